@@ -0,0 +1,135 @@
+/*
+VarioBarograph.cpp - Class definition file for the barograph logger of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "VarioBarograph.h"
+
+static void putLE16(uint8_t* aBuf, uint16_t aValue) {
+  aBuf[0] = aValue;
+  aBuf[1] = aValue >> 8;
+}
+
+static void putLE32(uint8_t* aBuf, uint32_t aValue) {
+  aBuf[0] = aValue;
+  aBuf[1] = aValue >> 8;
+  aBuf[2] = aValue >> 16;
+  aBuf[3] = aValue >> 24;
+}
+
+VarioBarograph::VarioBarograph(VarioMS5611& aVario, VarioLogSink& aSink) :
+  myVario(aVario), mySink(aSink) {
+}
+
+void VarioBarograph::begin(uint16_t aInterval) {
+  myActiveBlock = 0;
+  myActiveRecords = 0;
+  myPendingLength = 0;
+  mySequence = 0;
+  myDroppedBlocks = 0;
+  myRecordCnt = 0;
+  setInterval(aInterval);
+  myNextRecord = millis();
+}
+
+void VarioBarograph::setInterval(uint16_t aInterval) {
+  myInterval = aInterval > 0 ? aInterval : 1;
+}
+
+uint16_t VarioBarograph::getInterval(void) {
+  return myInterval;
+}
+
+uint32_t VarioBarograph::getRecordCount(void) {
+  return myRecordCnt;
+}
+
+uint16_t VarioBarograph::getDroppedBlocks(void) {
+  return myDroppedBlocks;
+}
+
+void VarioBarograph::run() {
+  unsigned long now = millis();
+  if ((long)(now - myNextRecord) >= 0) {
+    addRecord(now);
+    myNextRecord += myInterval;
+    if ((long)(now - myNextRecord) >= 0) {
+      // we are more than one interval late, do not try to catch up
+      myNextRecord = now + myInterval;
+    }
+  }
+
+  if (myPendingLength > 0 && mySink.isReady()) {
+    writePending();
+  }
+}
+
+void VarioBarograph::addRecord(unsigned long aTime) {
+  uint8_t* rec = myBlocks[myActiveBlock] + myActiveRecords * VARIO_BAROGRAPH_RECORD_SIZE;
+  double pressure = myVario.getSmoothedPressure();
+
+  putLE16(rec, mySequence);
+  putLE16(rec + 2, (int16_t) lround(myVario.getTemperature() * 100));
+  putLE32(rec + 4, aTime);
+  putLE32(rec + 8, (int32_t) lround(pressure));
+  putLE32(rec + 12, (int32_t) lround(myVario.calcAltitude(pressure, PRESSURE_SEALEVEL) * 100));
+  mySequence++;
+  myRecordCnt++;
+
+  if (++myActiveRecords < VARIO_BAROGRAPH_BLOCK_RECORDS) {
+    return;
+  }
+
+  // active block is full, swap the blocks
+  if (myPendingLength > 0) {
+    // the sink did not manage to store the previous block in time,
+    // drop the new one, the gap is visible in the sequence numbers
+    myDroppedBlocks++;
+  } else {
+    myPendingLength = VARIO_BAROGRAPH_BLOCK_SIZE;
+    myActiveBlock ^= 1;
+  }
+  myActiveRecords = 0;
+}
+
+bool VarioBarograph::writePending(void) {
+  if (!mySink.writeBlock(myBlocks[myActiveBlock ^ 1], myPendingLength)) {
+    // keep the block and retry at the next run()
+    return false;
+  }
+  myPendingLength = 0;
+  return true;
+}
+
+bool VarioBarograph::flush(void) {
+  if (myPendingLength > 0 && !writePending()) {
+    return false;
+  }
+  if (myActiveRecords > 0) {
+    if (!mySink.writeBlock(myBlocks[myActiveBlock], myActiveRecords * VARIO_BAROGRAPH_RECORD_SIZE)) {
+      return false;
+    }
+    myActiveRecords = 0;
+  }
+  return true;
+}
@@ -0,0 +1,202 @@
+/*
+VarioBarograph.h - Declaration file for the barograph logger of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file VarioBarograph.h
+ *
+ * \brief header file of the barograph logger, writing IGC-style pressure altitude records
+ *        of a VarioMS5611 instance to a pluggable storage sink
+ *
+ * \author Author: Rainer Stransky
+ *
+ * \copyright This project is released under the GNU Public License v3
+ *          see https://www.gnu.org/licenses/gpl.html.
+ * Contact: opensource@so-fa.de
+ *
+ */
+
+#ifndef VARIO_BAROGRAPH_h
+#define VARIO_BAROGRAPH_h
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "VarioMS5611.h"
+
+/// number of records collected in one block, before the block is handed over to the sink
+#ifndef VARIO_BAROGRAPH_BLOCK_RECORDS
+#define VARIO_BAROGRAPH_BLOCK_RECORDS   8
+#endif
+
+/// size in bytes of one barograph record
+/**
+ * record layout (all values little endian):
+ * * byte  0 : uint16_t sequence number, incremented by 1 for each record (wraps at 65536)
+ * * byte  2 : int16_t  temperature in 1/100 °C
+ * * byte  4 : uint32_t time stamp in ms (millis())
+ * * byte  8 : int32_t  smoothed pressure in Pa
+ * * byte 12 : int32_t  pressure altitude in cm, related to the standard pressure of 101325 Pa (as used by IGC)
+ */
+#define VARIO_BAROGRAPH_RECORD_SIZE     16
+#define VARIO_BAROGRAPH_BLOCK_SIZE      (VARIO_BAROGRAPH_BLOCK_RECORDS * VARIO_BAROGRAPH_RECORD_SIZE)
+
+/// storage sink interface used by the VarioBarograph
+/**
+ * implement this interface to store the barograph blocks e.g. on a SD card, a SPI flash
+ * or a file on the host. A block is always a multiple of VARIO_BAROGRAPH_RECORD_SIZE bytes.
+ * The methods are called within VarioBarograph::run() and must not block, otherwise they
+ * stall VarioMS5611::run() as well. A sink, that is not able to store a block at once, may store
+ * it in several parts: the block is offered again unchanged, till writeBlock() returns true.
+ */
+class VarioLogSink
+{
+    public:
+	virtual ~VarioLogSink() {}
+
+	/// check if the sink is able to take a block now
+	/** returns false, if the storage is busy (e.g. flash page erase is running),
+	 * the block is then kept and offered again at the next VarioBarograph::run()
+	 */
+	virtual bool isReady(void) { return true; }
+
+	/// write one block to the storage
+	/** returns true if the block has been stored completely */
+	virtual bool writeBlock(const uint8_t* aData, uint16_t aLength) = 0;
+};
+
+/// VarioLogSink writing the blocks to any Print instance (Serial, SD File, ...)
+/**
+ * By default only the free space of the transmit buffer (Print::availableForWrite()) is written,
+ * so a block is written in several parts and a slow Serial never blocks the loop.
+ * Print instances not implementing availableForWrite() always report 0 bytes. As long as no free
+ * space has been reported at all, the blocks are therefore written at once (blocking).
+ */
+class VarioPrintSink : public VarioLogSink
+{
+    public:
+	/// @param aOut Print instance the blocks are written to
+	/// @param aCheckBuffer if false, the free space of the buffer is not checked and each block is
+	///        written at once (blocking)
+	VarioPrintSink(Print& aOut, bool aCheckBuffer = true) :
+	  myOut(aOut), myCheckBuffer(aCheckBuffer), myBufferReported(false), myData(NULL), myOffset(0) {}
+	virtual bool isReady(void) {
+	  return getWriteLimit() > 0;
+	}
+	virtual bool writeBlock(const uint8_t* aData, uint16_t aLength) {
+	  if (aData != myData) {
+	    // a new block, not a continuation of a partially written one
+	    myData = aData;
+	    myOffset = 0;
+	  }
+	  uint16_t length = aLength - myOffset;
+	  int limit = getWriteLimit();
+	  if (limit < length) {
+	    length = limit;
+	  }
+	  myOffset += myOut.write(aData + myOffset, length);
+	  if (myOffset < aLength) {
+	    return false;
+	  }
+	  myData = NULL;
+	  return true;
+	}
+    private:
+	Print& myOut;
+	bool myCheckBuffer;
+	bool myBufferReported;
+	const uint8_t* myData;
+	uint16_t myOffset;
+
+	// number of bytes, which can be written without blocking
+	int getWriteLimit(void) {
+	  if (!myCheckBuffer) {
+	    return VARIO_BAROGRAPH_BLOCK_SIZE;
+	  }
+	  int available = myOut.availableForWrite();
+	  if (available > 0) {
+	    myBufferReported = true;
+	    return available;
+	  }
+	  // a full buffer, or availableForWrite() is not implemented
+	  return myBufferReported ? 0 : VARIO_BAROGRAPH_BLOCK_SIZE;
+	}
+};
+
+/// VarioBarograph logs pressure altitude records in a fixed interval to a VarioLogSink
+/**
+ * The records are collected in two fixed blocks (double buffering). While one block is filled,
+ * the other one is handed over to the sink. So a slow storage never stalls VarioMS5611::run(),
+ * as long as the sink does not block (see VarioLogSink). If the sink is too slow, complete blocks
+ * are dropped and can be detected by gaps in the record sequence numbers.
+ */
+class VarioBarograph
+{
+    public:
+	VarioBarograph(VarioMS5611& aVario, VarioLogSink& aSink);
+
+	/// for initialzation
+	/** has to be called once, after VarioMS5611::begin()
+	 * @param aInterval interval between two records in ms
+	 */
+	void begin(uint16_t aInterval = 1000);
+
+	/// set the interval between two records in ms
+	void setInterval(uint16_t aInterval);
+
+	/// get the interval between two records in ms
+	uint16_t getInterval(void);
+
+	/// non blocking logging method, has to be called in the loop next to VarioMS5611::run()
+	/**
+	 * - adds a record to the active block, if the record interval is reached
+	 * - hands over at most one complete block to the sink
+	 */
+	void run();
+
+	/// write all pending and the partially filled block to the sink (e.g. after landing)
+	/** returns true if all records have been stored */
+	bool flush(void);
+
+	/// get the number of records taken since begin()
+	uint32_t getRecordCount(void);
+
+	/// get the number of blocks dropped, because the sink was not able to store them in time
+	uint16_t getDroppedBlocks(void);
+
+    private:
+	VarioMS5611& myVario;
+	VarioLogSink& mySink;
+	uint8_t myBlocks[2][VARIO_BAROGRAPH_BLOCK_SIZE];
+	uint8_t myActiveBlock;
+	uint8_t myActiveRecords;
+	uint16_t myPendingLength;
+	uint16_t myInterval;
+	uint16_t mySequence;
+	uint16_t myDroppedBlocks;
+	uint32_t myRecordCnt;
+	unsigned long myNextRecord;
+
+	void addRecord(unsigned long aTime);
+	bool writePending(void);
+};
+
+#endif
@@ -0,0 +1,278 @@
+/*
+VarioFilter.cpp - Class definition file for the filter chain of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <math.h>
+
+#include "VarioMS5611.h"
+#include "VarioFilter.h"
+
+VarioFilter::VarioFilter() {
+  myPressureSmoothingFactor = 0.9d;
+  myAdaptiveSmoothing = false;
+  myAdaptiveMinFactor = 0.5d;
+  myAdaptiveMaxFactor = 0.95d;
+  myPressureNoise = 0.0d;
+  myInnovationVariance = 1.5d * 1.5d;
+  myVerticalSpeedSmoothingFactor = 0.9d;
+  myVerticalAccelerationSmoothingFactor = 0.9d;
+  myVerticalSpeedMode = VARIO_MODE_IIR;
+  myLastSampleTime = 0;
+  reset(PRESSURE_SEALEVEL);
+}
+
+void VarioFilter::reset(double aPressure) {
+  mySmoothedPressureVal = aPressure;
+  myEffectivePressureSmoothingFactor = myPressureSmoothingFactor;
+  myLastAltitude = VarioMS5611::calcAltitude(aPressure)*100;
+  myVerticalSpeed = 0;
+  myLastVerticalSpeed = 0.0d;
+  myVerticalAcceleration = 0.0d;
+  #ifdef VARIO_SG_FILTER
+  mySGPos = 0;
+  mySGCnt = 0;
+  #endif
+}
+
+double VarioFilter::getSmoothedPressure(void) {
+  return mySmoothedPressureVal;
+}
+
+void VarioFilter::setPressureNoise(double aNoise) {
+  myPressureNoise = aNoise;
+  myInnovationVariance = aNoise * aNoise;
+}
+
+double VarioFilter::getPressureSmoothingFactor(void) {
+  return myPressureSmoothingFactor;
+}
+
+void VarioFilter::setPressureSmoothingFactor(double aFactor) {
+  myPressureSmoothingFactor = aFactor;
+}
+
+void VarioFilter::setAdaptivePressureSmoothing(bool aEnable, double aMinFactor, double aMaxFactor) {
+  myAdaptiveSmoothing = aEnable;
+  myAdaptiveMinFactor = min(aMinFactor, aMaxFactor);
+  myAdaptiveMaxFactor = max(aMinFactor, aMaxFactor);
+  // start with the noise measured by the noise calibration or the typical noise of the MS5611
+  double noise = myPressureNoise > 0 ? myPressureNoise : 1.5;
+  myInnovationVariance = noise * noise;
+}
+
+bool VarioFilter::getAdaptivePressureSmoothing(void) {
+  return myAdaptiveSmoothing;
+}
+
+double VarioFilter::getAdaptivePressureSmoothingMinFactor(void) {
+  return myAdaptiveMinFactor;
+}
+
+double VarioFilter::getAdaptivePressureSmoothingMaxFactor(void) {
+  return myAdaptiveMaxFactor;
+}
+
+double VarioFilter::getEffectivePressureSmoothingFactor(void) {
+  return myEffectivePressureSmoothingFactor;
+}
+
+void VarioFilter::filter(int32_t aPressure, unsigned long aSampleTime, bool aWarmUpPhase) {
+  // Vario Filter
+  // IIR Low Pass Filter
+  // y[i] := α * x[i] + (1-α) * y[i-1]
+  //      := α * x[i] + (1 * y[i-1]) - (α * y[i-1])
+  //      := α * x[i] +  y[i-1] - α * y[i-1]
+  //      := α * ( x[i] - y[i-1]) + y[i-1]
+  //      := y[i-1] + α * (x[i] - y[i-1])
+  // mit α = 1- β
+  //      := y[i-1] + (1-ß) * (x[i] - y[i-1])
+  //      := y[i-1] + 1 * (x[i] - y[i-1]) - ß * (x[i] - y[i-1])
+  //      := y[i-1] + x[i] - y[i-1] - ß * x[i] + ß * y[i-1]
+  //      := x[i] - ß * x[i] + ß * y[i-1]
+  //      := x[i] + ß * y[i-1] - ß * x[i]
+  //      := x[i] + ß * (y[i-1] - x[i])
+  
+  myEffectivePressureSmoothingFactor = myPressureSmoothingFactor;
+  if (myAdaptiveSmoothing && !aWarmUpPhase) {
+    // innovation adaptive smoothing factor
+    double innovation = aPressure - mySmoothedPressureVal;
+    double innovation2 = innovation * innovation;
+    double ratio = sqrt(innovation2 / myInnovationVariance);
+    myEffectivePressureSmoothingFactor = myAdaptiveMaxFactor
+        - (myAdaptiveMaxFactor - myAdaptiveMinFactor) * constrain((ratio - 1.0) / 3.0, 0.0, 1.0);
+    // running noise estimate, innovations are limited to 3 sigma,
+    // so real pressure changes do not inflate the noise estimate
+    myInnovationVariance += 0.01 * (min(innovation2, 9 * myInnovationVariance) - myInnovationVariance);
+    if (myInnovationVariance < 0.1) {
+      myInnovationVariance = 0.1;
+    }
+  }
+  mySmoothedPressureVal = (double) aPressure + myEffectivePressureSmoothingFactor * (mySmoothedPressureVal - aPressure);
+  
+  calcVerticalSpeed(aSampleTime, aWarmUpPhase);
+}
+
+void VarioFilter::setVerticalSpeedSmoothingFactor(double aFactor) {
+  myVerticalSpeedSmoothingFactor = aFactor;
+}
+
+double VarioFilter::getVerticalSpeedSmoothingFactor(void) {
+  return myVerticalSpeedSmoothingFactor;
+}
+
+void VarioFilter::setVerticalAccelerationSmoothingFactor(double aFactor) {
+  myVerticalAccelerationSmoothingFactor = aFactor;
+}
+
+double VarioFilter::getVerticalAccelerationSmoothingFactor(void) {
+  return myVerticalAccelerationSmoothingFactor;
+}
+
+void VarioFilter::calcVerticalSpeed(unsigned long aSampleTime, bool aWarmUpPhase) {
+  // Vario calculation
+  unsigned long dT = aSampleTime - myLastSampleTime;     // delta time in ms
+  if (dT == 0) {
+    // duplicated time stamp, no derivative possible
+    return;
+  }
+
+  double altitude = VarioMS5611::calcAltitude(getSmoothedPressure())*100; // altitude in cm
+  double vspeed;
+  #ifdef VARIO_SG_FILTER
+  if (myVerticalSpeedMode == VARIO_MODE_SAVITZKY_GOLAY) {
+    if (!calcSavitzkyGolay(altitude, aSampleTime, vspeed)) {
+      // window not filled yet, keep the last value
+      vspeed = myLastVerticalSpeed;
+    }
+  } else
+  #endif
+  {
+    if (aWarmUpPhase) {
+      myLastAltitude = altitude;
+    }
+    vspeed = (altitude - myLastAltitude) * (1000.0 / dT);
+    vspeed = vspeed + myVerticalSpeedSmoothingFactor * (myVerticalSpeed - vspeed);
+  }
+  myVerticalSpeed = vspeed;
+
+  // vertical acceleration, derived from the not truncated vertical speed
+  if (aWarmUpPhase) {
+    myLastVerticalSpeed = vspeed;
+  }
+  double vaccel = (vspeed - myLastVerticalSpeed) * (1000.0 / dT);
+  myVerticalAcceleration = vaccel + myVerticalAccelerationSmoothingFactor * (myVerticalAcceleration - vaccel);
+  myLastVerticalSpeed = vspeed;
+
+  myLastAltitude = altitude;
+  myLastSampleTime = aSampleTime;
+}
+
+bool VarioFilter::setVerticalSpeedMode(vario_mode_t aMode, uint8_t aWindowLength, uint8_t aPolynomialOrder) {
+  if (aMode == VARIO_MODE_IIR) {
+    myVerticalSpeedMode = aMode;
+    return true;
+  }
+  #ifdef VARIO_SG_FILTER
+  if (aMode != VARIO_MODE_SAVITZKY_GOLAY || aWindowLength < 5 || aWindowLength > VARIO_SG_MAX_WINDOW
+      || aWindowLength % 2 == 0 || aPolynomialOrder < 1 || aPolynomialOrder > 4) {
+    return false;
+  }
+  // coefficients of the derivative in the center of the window: c[-i] = -c[i]
+  // order 1/2: least square fit of a1*i          -> c[i] = i / S2
+  // order 3/4: least square fit of a1*i + a3*i^3 -> c[i] = (S6*i - S4*i^3) / (S2*S6 - S4^2)
+  // with Sk = sum of i^k over the window
+  uint8_t m = aWindowLength / 2;
+  double s2 = 0, s4 = 0, s6 = 0;
+  for (uint8_t i = 1; i <= m; i++) {
+    double i2 = (double) i * i;
+    s2 += 2 * i2;
+    s4 += 2 * i2 * i2;
+    s6 += 2 * i2 * i2 * i2;
+  }
+  for (uint8_t i = 1; i <= m; i++) {
+    if (aPolynomialOrder <= 2) {
+      mySGCoefficients[i-1] = i / s2;
+    } else {
+      mySGCoefficients[i-1] = (s6 * i - s4 * i * i * i) / (s2 * s6 - s4 * s4);
+    }
+  }
+  mySGHalfWindow = m;
+  mySGPos = 0;
+  mySGCnt = 0;
+  myVerticalSpeedMode = aMode;
+  return true;
+  #else
+  (void) aWindowLength;
+  (void) aPolynomialOrder;
+  return false;
+  #endif
+}
+
+vario_mode_t VarioFilter::getVerticalSpeedMode(void) {
+  return myVerticalSpeedMode;
+}
+
+#ifdef VARIO_SG_FILTER
+bool VarioFilter::calcSavitzkyGolay(double aAltitude, unsigned long aSampleTime, double& aVerticalSpeed) {
+  mySGAltitude[mySGPos] = aAltitude;
+  mySGTime[mySGPos] = aSampleTime;
+  uint8_t newest = mySGPos;
+  if (++mySGPos >= VARIO_SG_MAX_WINDOW) {
+    mySGPos = 0;
+  }
+  uint8_t window = 2 * mySGHalfWindow + 1;
+  if (mySGCnt < window) {
+    mySGCnt++;
+    if (mySGCnt < window) {
+      return false;
+    }
+  }
+
+  // index of the center sample of the window
+  uint8_t center = (newest + VARIO_SG_MAX_WINDOW - mySGHalfWindow) % VARIO_SG_MAX_WINDOW;
+  uint8_t oldest = (newest + VARIO_SG_MAX_WINDOW - 2 * mySGHalfWindow) % VARIO_SG_MAX_WINDOW;
+  double sum = 0;
+  for (uint8_t i = 1; i <= mySGHalfWindow; i++) {
+    uint8_t later = (center + i) % VARIO_SG_MAX_WINDOW;
+    uint8_t earlier = (center + VARIO_SG_MAX_WINDOW - i) % VARIO_SG_MAX_WINDOW;
+    sum += mySGCoefficients[i-1] * (mySGAltitude[later] - mySGAltitude[earlier]);
+  }
+
+  // the filter assumes equidistant samples, use the mean sample interval of the window
+  unsigned long span = mySGTime[newest] - mySGTime[oldest];
+  if (span == 0) {
+    return false;
+  }
+  aVerticalSpeed = sum * (2000.0 * mySGHalfWindow / span);
+  return true;
+}
+#endif
+
+int VarioFilter::getVerticalSpeed(void) { 
+  return myVerticalSpeed;
+}
+
+double VarioFilter::getVerticalAcceleration(void) { 
+  return myVerticalAcceleration;
+}
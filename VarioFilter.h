@@ -0,0 +1,163 @@
+/*
+VarioFilter.h - Declaration file for the filter chain of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file VarioFilter.h
+ *
+ * \brief header file of the filter chain, calculating the smoothed pressure, vertical speed and
+ *        vertical acceleration from the temperature compensated pressure values of the MS5611
+ *
+ * \author Author: Rainer Stransky
+ *
+ * \copyright This project is released under the GNU Public License v3
+ *          see https://www.gnu.org/licenses/gpl.html.
+ * Contact: opensource@so-fa.de
+ *
+ */
+
+#ifndef VARIO_FILTER_h
+#define VARIO_FILTER_h
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+/**
+ * calculation modes of the vertical speed (variometer) value
+ */
+typedef enum
+{
+    VARIO_MODE_IIR,             ///< differentiation of the smoothed pressure, smoothed by an IIR Low Pass Filter (default)
+    VARIO_MODE_SAVITZKY_GOLAY   ///< Savitzky-Golay smoothing differentiator over a window of altitude samples (needs VARIO_SG_FILTER)
+} vario_mode_t;
+
+#ifdef VARIO_SG_FILTER
+/// maximal window length (odd) of the Savitzky-Golay filter (8 bytes RAM per sample)
+#ifndef VARIO_SG_MAX_WINDOW
+#define VARIO_SG_MAX_WINDOW       17
+#endif
+#endif
+
+/// VarioFilter, the filter chain from the compensated pressure values to the smoothed pressure, vertical speed and acceleration
+/**
+ * VarioMS5611 uses one VarioFilter instance for the values provided by its getXXX() methods.
+ * A second, independently configured instance can be set as shadow filter (VarioMS5611::setShadowFilter()),
+ * it is fed with the same compensated pressure samples, so that two filter setups can be compared
+ * under identical conditions.
+ * The meaning of the parameters is documented at the according methods of VarioMS5611.
+ */
+class VarioFilter
+{
+    public:
+	VarioFilter();
+
+	/// reset the filter state to the given pressure in Pa, the parameters are kept
+	void reset(double aPressure);
+
+	/// filter one compensated pressure sample
+	/**
+	 * @param aPressure temperature compensated pressure in Pa
+	 * @param aSampleTime time stamp of the sample in ms
+	 * @param aWarmUpPhase true while the sensor is in its warm-up phase
+	 */
+	void filter(int32_t aPressure, unsigned long aSampleTime, bool aWarmUpPhase);
+
+	/// get the smoothed pressure value in Pa
+	double getSmoothedPressure(void);
+
+	/// get the vertial speed value (variometer) in cm/s
+	int getVerticalSpeed(void);
+
+	/// get the vertical acceleration value in cm/s²
+	double getVerticalAcceleration(void);
+
+	/// set the IIR smoothing factor for the pressure value
+	void setPressureSmoothingFactor(double aFactor);
+
+	/// get the IIR smoothing factor for the pressure value
+	double getPressureSmoothingFactor(void);
+
+	/// enable the innovation adaptive smoothing of the pressure value
+	void setAdaptivePressureSmoothing(bool aEnable, double aMinFactor = 0.5, double aMaxFactor = 0.95);
+
+	/// returns true if the innovation adaptive smoothing of the pressure value is enabled
+	bool getAdaptivePressureSmoothing(void);
+
+	/// get the lower bound of the innovation adaptive smoothing factor
+	double getAdaptivePressureSmoothingMinFactor(void);
+
+	/// get the upper bound of the innovation adaptive smoothing factor
+	double getAdaptivePressureSmoothingMaxFactor(void);
+
+	/// get the IIR smoothing factor used for the last pressure value
+	double getEffectivePressureSmoothingFactor(void);
+
+	/// set the pressure noise (standard deviation in Pa) used to seed the adaptive smoothing
+	void setPressureNoise(double aNoise);
+
+	/// set the IIR smoothing factor for the vertical speed (variometer) value
+	void setVerticalSpeedSmoothingFactor(double aFactor);
+
+	/// get the IIR smoothing factor for the vertical speed (variometer) value
+	double getVerticalSpeedSmoothingFactor(void);
+
+	/// set the calculation mode of the vertical speed (variometer) value
+	bool setVerticalSpeedMode(vario_mode_t aMode, uint8_t aWindowLength = 9, uint8_t aPolynomialOrder = 2);
+
+	/// get the calculation mode of the vertical speed (variometer) value
+	vario_mode_t getVerticalSpeedMode(void);
+
+	/// set the IIR smoothing factor for the vertical acceleration value
+	void setVerticalAccelerationSmoothingFactor(double aFactor);
+
+	/// get the IIR smoothing factor for the vertical acceleration value
+	double getVerticalAccelerationSmoothingFactor(void);
+
+    private:
+	double myPressureSmoothingFactor;
+	bool myAdaptiveSmoothing;
+	double myAdaptiveMinFactor;
+	double myAdaptiveMaxFactor;
+	double myEffectivePressureSmoothingFactor;
+	double myPressureNoise;
+	double myInnovationVariance;
+	double mySmoothedPressureVal;
+	int myVerticalSpeed;
+	double myVerticalSpeedSmoothingFactor;
+	double myLastVerticalSpeed;
+	double myVerticalAcceleration;
+	double myVerticalAccelerationSmoothingFactor;
+	double myLastAltitude;
+	unsigned long myLastSampleTime;
+	vario_mode_t myVerticalSpeedMode;
+	#ifdef VARIO_SG_FILTER
+	float mySGCoefficients[VARIO_SG_MAX_WINDOW/2];
+	float mySGAltitude[VARIO_SG_MAX_WINDOW];
+	unsigned long mySGTime[VARIO_SG_MAX_WINDOW];
+	uint8_t mySGHalfWindow;
+	uint8_t mySGPos;
+	uint8_t mySGCnt;
+	bool calcSavitzkyGolay(double aAltitude, unsigned long aSampleTime, double& aVerticalSpeed);
+	#endif
+	void calcVerticalSpeed(unsigned long aSampleTime, bool aWarmUpPhase);
+};
+
+#endif
@@ -28,35 +28,88 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "VarioMS5611.h"
 
-bool VarioMS5611::begin(ms5611_osr_t aSamplingRate) {
-    Wire.begin();
+bool VarioMS5611::begin(ms5611_osr_t aSamplingRate, uint8_t aAddress, TwoWire& aWire) {
+    myAddress = aAddress;
+    myWire = &aWire;
+    myNextRead = 0;
+    myWire->begin();
     reset();
+    myMaxDutyCycle = 1.0f;
     setOversampling(aSamplingRate);
     delay(100);
     readPROM();
-
-    myPendingValueType = NONE;
-    myPressureSmoothingFactor = 0.9d;
+    initState();
 
     // set a valid inital value
     for (int i=0; i < 50; i++) {
-      mySmoothedPressureVal = readPressure(true);
+      myFilter.reset(readPressure(true));
     }
     myRawTemperatureVal_D2 = readRawTemperature();
-    myVerticalSpeed = 0.0d;
-    myVerticalSpeedSmoothingFactor = 0.9d;
     myTemperatureVal = readTemperature(true);
     myReferenceHeight = calcAltitude(getSmoothedPressure());     
+    startAcquisition();
+
+    return true;
+}
+
+bool VarioMS5611::begin(const uint16_t* aCalibration, bool aWarmUp) {
+    myAddress = MS5611_ADDRESS;
+    myWire = NULL;
+    myNextRead = 0;
+    myMaxDutyCycle = 1.0f;
+    setOversampling(MS5611_ULTRA_HIGH_RES);
+    memcpy(myCompensationValues, aCalibration, sizeof(myCompensationValues));
+    initState();
+
+    // no sample yet, the filter is set to the first sample of processRawSample()
+    myRawPressureVal_D1 = 0;
+    myRawTemperatureVal_D2 = (uint32_t) myCompensationValues[4] * 256;
+    myPressureVal = 0;
+    myTemperatureVal = calcTemperature(myRawTemperatureVal_D2, false);
+    myReferenceHeight = 0;
+    startAcquisition();
+    myWarmUpPhase = aWarmUp;
+
+    return true;
+}
+
+void VarioMS5611::initState(void) {
+    // used by the samples read within begin(), the instance may be on the stack or heap
+    myRunCnt = 0;
+    myWarmUpPhase = true;
+    myCalibrationTarget = 0;
     myDoSecondOrderCompensation = false;
+    myPendingValueType = NONE;
+    myFilter = VarioFilter();
+    myShadowFilter = NULL;
+    #ifdef VARIO_BLACKBOX
+    // do not record the initialization samples
+    myBlackBoxTrigger = 0;
+    myBlackBoxFrozen = true;
+    #endif
+}
+
+void VarioMS5611::startAcquisition(void) {
+    myDoSecondOrderCompensation = false;
+    setNoiseCalibration(0);
     myRunCnt = 0;
     myWarmUpPhase = true;
     #ifdef VARIO_EXTENDED_INTERFACE
     myReadsCnt = 0;
     myReadsCntTimer = millis();
     myReadsPerSecond = 0.0f;
+    myConversionTime = 0;
+    myTrendTemperatureVal = calcTemperature(myRawTemperatureVal_D2, myDoSecondOrderCompensation);
+    myDutyCycle = 0.0f;
+    myTemperatureTrend = 0.0f;
+    #endif
+    #ifdef VARIO_BLACKBOX
+    releaseBlackBox();
+    #endif
+    #ifdef VARIO_SAMPLE_AGE_TRACE
+    myTraceConsumed = true;
+    resetSampleAgeHistogram();
     #endif
-
-    return true;
 }
 
 void VarioMS5611::setOversampling(ms5611_osr_t osr)
@@ -81,6 +134,18 @@ void VarioMS5611::setOversampling(ms5611_osr_t osr)
     }
 
     myuosr = osr;
+    setMaxDutyCycle(myMaxDutyCycle);
+}
+
+void VarioMS5611::setMaxDutyCycle(float aDutyCycle) {
+    myMaxDutyCycle = constrain(aDutyCycle, 0.1f, 1.0f);
+    // idle time in ms after each conversion, to keep the conversion time
+    // myct within the given part of the time
+    myIdleTime = ceil(myct * (1.0f / myMaxDutyCycle - 1.0f));
+}
+
+float VarioMS5611::getMaxDutyCycle(void) {
+    return myMaxDutyCycle;
 }
 
 ms5611_osr_t VarioMS5611::getOversampling(void)
@@ -90,15 +155,15 @@ ms5611_osr_t VarioMS5611::getOversampling(void)
 
 void VarioMS5611::reset(void)
 {
-    Wire.beginTransmission(MS5611_ADDRESS);
+    myWire->beginTransmission(myAddress);
 
     #if ARDUINO >= 100
-	Wire.write(MS5611_CMD_RESET);
+	myWire->write(MS5611_CMD_RESET);
     #else
-	Wire.send(MS5611_CMD_RESET);
+	myWire->send(MS5611_CMD_RESET);
     #endif
 
-    Wire.endTransmission();
+    myWire->endTransmission();
 }
 
 void VarioMS5611::readPROM(void)
@@ -122,34 +187,46 @@ uint32_t VarioMS5611::getRawTemperature(void) {
 }
 
 boolean VarioMS5611::triggerReadValues(vario_value_t aRequestType) {
-  static unsigned long nextRead = 0;
   boolean retVal = false;
 
-  if (millis() > (nextRead)) {
+  if (myWire == NULL) {
+    // no MS5611 connected, the values of the last processRawSample() are kept
+    return true;
+  }
+
+  if (millis() > (myNextRead)) {
     // values can be read now !!!
     myRunCnt++;
     if (myRunCnt == 100 ) {
-      myWarmUpPhase = false;
-      // after a couple (100) of run()'s the temperature of the sensor is more stable
-      // so some values has to be fixed finally
-      myReferenceHeight = calcAltitude(getSmoothedPressure());     
+      finishWarmUp();
     }
     #ifdef VARIO_EXTENDED_INTERFACE
     if ( (myReadsCntTimer+1000) < millis() ) {
-      myReadsPerSecond = (float) myReadsCnt / ((millis() - myReadsCntTimer)/1000);
+      unsigned long elapsed = millis() - myReadsCntTimer;
+      myReadsPerSecond = (float) myReadsCnt / (elapsed/1000);
+      myDutyCycle = (float) myConversionTime / elapsed;
+      // temperature trend in °C/min, smoothed by an IIR filter
+      float trend = (myTemperatureVal - myTrendTemperatureVal) * 600.0f / elapsed;
+      myTemperatureTrend = trend + 0.95f * (myTemperatureTrend - trend);
+      myTrendTemperatureVal = myTemperatureVal;
       myReadsCntTimer = millis();
       myReadsCnt = 0;
+      myConversionTime = 0;
     }
+    myConversionTime += myct;
     #endif
     if (myPendingValueType == DIGITAL_PRESSURE_VALUE) {
         #ifdef VARIO_EXTENDED_INTERFACE
         myReadsCnt++;
         #endif
         myRawPressureVal_D1 = readRegister24(MS5611_CMD_ADC_READ);
-	myTemperatureVal = calcTemperature(myRawTemperatureVal_D2);
-	myPressureVal = calcTemperatureCompensatedPressure(myRawPressureVal_D1, myRawTemperatureVal_D2);
-	calcFilter();
-
+        mySampleTime = millis();
+        #ifdef VARIO_SAMPLE_AGE_TRACE
+        myTraceRead = micros();
+        // the next conversion start overwrites myTraceConversionStart, before this sample is consumed
+        myTraceSampleStart = myTraceConversionStart;
+        #endif
+        processPressureSample();
     } else if (myPendingValueType == DIGITAL_TEMPERATURE_VALUE) {
         myRawTemperatureVal_D2 = readRegister24(MS5611_CMD_ADC_READ);
     } else {
@@ -181,14 +258,19 @@ boolean VarioMS5611::triggerReadValues(vario_value_t aRequestType) {
     }
 
     // request data and do not wait for answer
-    Wire.beginTransmission(MS5611_ADDRESS);
+    myWire->beginTransmission(myAddress);
     #if ARDUINO >= 100
-      Wire.write(valueAddr);
+      myWire->write(valueAddr);
     #else
-      Wire.send(valueAddr);
+      myWire->send(valueAddr);
     #endif
-    Wire.endTransmission();
-    nextRead = millis() + myct;
+    myWire->endTransmission();
+    #ifdef VARIO_SAMPLE_AGE_TRACE
+    if (myPendingValueType == DIGITAL_PRESSURE_VALUE) {
+      myTraceConversionStart = micros();
+    }
+    #endif
+    myNextRead = millis() + myct + myIdleTime;
     
   } else {
     // do nothing, there is an pending value requested and we have to wait 
@@ -197,6 +279,63 @@ boolean VarioMS5611::triggerReadValues(vario_value_t aRequestType) {
   return retVal;
 }
 
+void VarioMS5611::finishWarmUp(void) {
+  myWarmUpPhase = false;
+  // after a couple (100) of run()'s the temperature of the sensor is more stable
+  // so some values has to be fixed finally
+  myReferenceHeight = calcAltitude(myFilter.getSmoothedPressure());     
+  if (myCalibrationTarget > 0) {
+    finishNoiseCalibration();
+  }
+}
+
+void VarioMS5611::processPressureSample(void) {
+  myTemperatureVal = calcTemperature(myRawTemperatureVal_D2, myDoSecondOrderCompensation);
+  myPressureVal = calcTemperatureCompensatedPressure(myRawPressureVal_D1, myRawTemperatureVal_D2, myDoSecondOrderCompensation);
+  if (myWarmUpPhase && myCalibrationTarget > 0) {
+    calibrateNoise();
+  }
+  myFilter.filter(myPressureVal, mySampleTime, myWarmUpPhase);
+  if (myShadowFilter != NULL) {
+    myShadowFilter->filter(myPressureVal, mySampleTime, myWarmUpPhase);
+  }
+  #ifdef VARIO_BLACKBOX
+  recordBlackBox();
+  #endif
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  myTracePublished = micros();
+  myTraceConsumed = false;
+  #endif
+}
+
+void VarioMS5611::processRawSample(uint32_t aRawPressure, uint32_t aRawTemperature, unsigned long aTime) {
+  if (myRunCnt == 0) {
+    // first sample, set the filter state (see begin(const uint16_t*))
+    int32_t pressure = calcTemperatureCompensatedPressure(aRawPressure, aRawTemperature, myDoSecondOrderCompensation);
+    myFilter.reset(pressure);
+    if (myShadowFilter != NULL) {
+      myShadowFilter->reset(pressure);
+    }
+    myReferenceHeight = calcAltitude(pressure);
+  }
+  // one pressure and one temperature read
+  myRunCnt += 2;
+  if (myWarmUpPhase && myRunCnt >= 100) {
+    finishWarmUp();
+  }
+  myRawPressureVal_D1 = aRawPressure;
+  myRawTemperatureVal_D2 = aRawTemperature;
+  mySampleTime = aTime;
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  myTraceSampleStart = myTraceRead = micros();
+  #endif
+  processPressureSample();
+}
+
+const uint16_t* VarioMS5611::getCalibrationValues(void) {
+  return myCompensationValues;
+}
+
 uint32_t VarioMS5611::readRawPressure(void)
 {
   while (!triggerReadValues(DIGITAL_PRESSURE_VALUE)) {
@@ -210,7 +349,7 @@ uint32_t VarioMS5611::getRawPressure(void) {
 }
 
 
-int32_t VarioMS5611::calcTemperature(uint32_t aRawTemperature) {
+int32_t VarioMS5611::calcTemperature(uint32_t aRawTemperature, bool aCompensation) {
     uint32_t D2 = aRawTemperature;
     int32_t dT = D2 - (uint32_t)myCompensationValues[4] * 256;
 
@@ -219,11 +358,12 @@ int32_t VarioMS5611::calcTemperature(uint32_t aRawTemperature) {
     myTEMP2 = 0;
 
     // second order temperature compensation
-    if (myDoSecondOrderCompensation) 
+    if (aCompensation) 
     {
 	if (TEMP < 2000)
 	{
-	    myTEMP2 = (dT * dT) / INT32_MAX;
+	    // T2 = dT² / 2^31, dT² does not fit into 32 bit
+	    myTEMP2 = ((int64_t) dT * dT) / 2147483648LL;
 	}
     }
 
@@ -233,13 +373,13 @@ int32_t VarioMS5611::calcTemperature(uint32_t aRawTemperature) {
     return TEMP;
 }
 
-int32_t VarioMS5611::calcTemperatureCompensatedPressure(uint32_t aRawPressure, uint32_t aRawTemperature) {
+int32_t VarioMS5611::calcTemperatureCompensatedPressure(uint32_t aRawPressure, uint32_t aRawTemperature, bool aCompensation) {
 
     int32_t dT = aRawTemperature - (uint32_t)myCompensationValues[4] * 256;
     int64_t OFF = (int64_t)myCompensationValues[1] * 65536 + (int64_t)myCompensationValues[3] * dT / 128;
     int64_t SENS = (int64_t)myCompensationValues[0] * 32768 + (int64_t)myCompensationValues[2] * dT / 256;
 
-    if (myDoSecondOrderCompensation) 
+    if (aCompensation) 
     {
 	int32_t TEMP = 2000 + ((int64_t) dT * myCompensationValues[5]) / 8388608;
 
@@ -267,6 +407,35 @@ int32_t VarioMS5611::calcTemperatureCompensatedPressure(uint32_t aRawPressure, u
     return result;
 }
 
+bool VarioMS5611::selfTest(void) {
+    // example calibration values of the MS5611 datasheet
+    static const uint16_t exampleValues[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+    // D1, D2 -> TEMP, P without and with second order compensation
+    // the datasheet example (20.07°C, 1000.09 mbar) and values at 10°C and -20°C, checked against
+    // a double precision implementation of the datasheet formulas (see extras/CompensationTest.cpp)
+    static const struct {
+      uint32_t d1, d2;
+      int32_t temp[2], pressure[2];
+    } vectors[] = {
+      { 9085466, 8569150, {  2007,  2007 }, { 100009, 100009 } },
+      { 9085466, 8270494, {  1001,   961 }, {  98070,  97981 } },
+      { 9085466, 7381624, { -1999, -2653 }, {  92300,  90749 } }
+    };
+    uint16_t deviceValues[6];
+    bool ok = true;
+
+    memcpy(deviceValues, myCompensationValues, sizeof(deviceValues));
+    memcpy(myCompensationValues, exampleValues, sizeof(exampleValues));
+    for (uint8_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+      for (uint8_t compensation = 0; compensation < 2; compensation++) {
+        ok = ok && calcTemperature(vectors[i].d2, compensation) == vectors[i].temp[compensation];
+        ok = ok && calcTemperatureCompensatedPressure(vectors[i].d1, vectors[i].d2, compensation) == vectors[i].pressure[compensation];
+      }
+    }
+    memcpy(myCompensationValues, deviceValues, sizeof(deviceValues));
+    return ok;
+}
+
 void VarioMS5611::setSecondOrderCompenstation(bool aDoCompensate) {
   myDoSecondOrderCompensation = aDoCompensate;
 }
@@ -275,63 +444,146 @@ bool VarioMS5611::getSecondOrderCompenstation() {
   return myDoSecondOrderCompensation;
 }
 
+
 double VarioMS5611::getPressureSmoothingFactor(void) {
-  return myPressureSmoothingFactor;
+  return myFilter.getPressureSmoothingFactor();
 }
 
 void VarioMS5611::setPressureSmoothingFactor(double aFactor) {
-  myPressureSmoothingFactor = aFactor;
-}
-
-void VarioMS5611::calcFilter(void) {
-  // Vario Filter
-  // IIR Low Pass Filter
-  // y[i] := α * x[i] + (1-α) * y[i-1]
-  //      := α * x[i] + (1 * y[i-1]) - (α * y[i-1])
-  //      := α * x[i] +  y[i-1] - α * y[i-1]
-  //      := α * ( x[i] - y[i-1]) + y[i-1]
-  //      := y[i-1] + α * (x[i] - y[i-1])
-  // mit α = 1- β
-  //      := y[i-1] + (1-ß) * (x[i] - y[i-1])
-  //      := y[i-1] + 1 * (x[i] - y[i-1]) - ß * (x[i] - y[i-1])
-  //      := y[i-1] + x[i] - y[i-1] - ß * x[i] + ß * y[i-1]
-  //      := x[i] - ß * x[i] + ß * y[i-1]
-  //      := x[i] + ß * y[i-1] - ß * x[i]
-  //      := x[i] + ß * (y[i-1] - x[i])
-  
-  mySmoothedPressureVal = (double) myPressureVal + myPressureSmoothingFactor * (mySmoothedPressureVal - myPressureVal);
-  
-  calcVerticalSpeed();
+  myFilter.setPressureSmoothingFactor(aFactor);
+}
+
+void VarioMS5611::setAdaptivePressureSmoothing(bool aEnable, double aMinFactor, double aMaxFactor) {
+  myFilter.setAdaptivePressureSmoothing(aEnable, aMinFactor, aMaxFactor);
+}
+
+bool VarioMS5611::getAdaptivePressureSmoothing(void) {
+  return myFilter.getAdaptivePressureSmoothing();
+}
+
+double VarioMS5611::getAdaptivePressureSmoothingMinFactor(void) {
+  return myFilter.getAdaptivePressureSmoothingMinFactor();
+}
+
+double VarioMS5611::getAdaptivePressureSmoothingMaxFactor(void) {
+  return myFilter.getAdaptivePressureSmoothingMaxFactor();
+}
+
+double VarioMS5611::getEffectivePressureSmoothingFactor(void) {
+  return myFilter.getEffectivePressureSmoothingFactor();
 }
 
 void VarioMS5611::setVerticalSpeedSmoothingFactor(double aFactor) {
-  myVerticalSpeedSmoothingFactor = aFactor;
+  myFilter.setVerticalSpeedSmoothingFactor(aFactor);
 }
 
 double VarioMS5611::getVerticalSpeedSmoothingFactor(void) {
-  return myVerticalSpeedSmoothingFactor;
+  return myFilter.getVerticalSpeedSmoothingFactor();
 }
 
-void VarioMS5611::calcVerticalSpeed(void) {
-  // Vario calculation
-  static unsigned long lastTime = 0;
-  unsigned long dT = millis() - lastTime;     // delta time in ms
-  static double lastAltitude = 0;
+bool VarioMS5611::setVerticalSpeedMode(vario_mode_t aMode, uint8_t aWindowLength, uint8_t aPolynomialOrder) {
+  return myFilter.setVerticalSpeedMode(aMode, aWindowLength, aPolynomialOrder);
+}
 
-  double altitude = calcAltitude(getSmoothedPressure())*100; // altitude in cm
-  if (myWarmUpPhase) {
-    lastAltitude = altitude;
-  }
-  double vspeed = (altitude - lastAltitude) * (1000.0 / dT);
-  myVerticalSpeed = vspeed + myVerticalSpeedSmoothingFactor * (myVerticalSpeed - vspeed);
-  lastAltitude = altitude;
-  lastTime = millis();
+vario_mode_t VarioMS5611::getVerticalSpeedMode(void) {
+  return myFilter.getVerticalSpeedMode();
+}
+
+void VarioMS5611::setVerticalAccelerationSmoothingFactor(double aFactor) {
+  myFilter.setVerticalAccelerationSmoothingFactor(aFactor);
+}
+
+double VarioMS5611::getVerticalAccelerationSmoothingFactor(void) {
+  return myFilter.getVerticalAccelerationSmoothingFactor();
 }
 
 int VarioMS5611::getVerticalSpeed(void) { 
-  return myVerticalSpeed;
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  traceSampleAge();
+  #endif
+  return myFilter.getVerticalSpeed();
+}
+
+double VarioMS5611::getVerticalAcceleration(void) { 
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  traceSampleAge();
+  #endif
+  return myFilter.getVerticalAcceleration();
+}
+
+void VarioMS5611::setShadowFilter(VarioFilter* aFilter) {
+  myShadowFilter = aFilter;
+  if (myShadowFilter != NULL) {
+    myShadowFilter->reset(myFilter.getSmoothedPressure());
+    if (myPressureNoise > 0) {
+      myShadowFilter->setPressureNoise(myPressureNoise);
+    }
+  }
+}
+
+VarioFilter* VarioMS5611::getShadowFilter(void) {
+  return myShadowFilter;
+}
+
+void VarioMS5611::setNoiseCalibration(double aTargetVerticalSpeedSigma) {
+  myCalibrationTarget = aTargetVerticalSpeedSigma;
+  myCalibrationCnt = 0;
+  myCalibrationMean = 0;
+  myCalibrationM2 = 0;
+  myPressureNoise = 0;
+}
+
+double VarioMS5611::getPressureNoise(void) {
+  return myPressureNoise;
+}
+
+void VarioMS5611::calibrateNoise(void) {
+  // the variance of the differences of consecutive pressure values is 2*σp²,
+  // and is not affected by a slow drift of the pressure (Welford's algorithm)
+  if (myCalibrationCnt == 0) {
+    myCalibrationStart = mySampleTime;
+  } else {
+    double diff = myPressureVal - myCalibrationLastPressure;
+    double delta = diff - myCalibrationMean;
+    myCalibrationMean += delta / myCalibrationCnt;
+    myCalibrationM2 += delta * (diff - myCalibrationMean);
+  }
+  myCalibrationLastPressure = myPressureVal;
+  myCalibrationCnt++;
+}
+
+void VarioMS5611::finishNoiseCalibration(void) {
+  unsigned long elapsed = mySampleTime - myCalibrationStart;
+  if (myCalibrationCnt < 10 || elapsed == 0) {
+    // not enough samples, keep the current smoothing factors
+    return;
+  }
+  myPressureNoise = sqrt(myCalibrationM2 / (myCalibrationCnt - 2) / 2);
+  if (myPressureNoise < 0.3) {
+    // at least the quantization noise of the pressure value in Pa
+    myPressureNoise = 0.3;
+  }
+  myFilter.setPressureNoise(myPressureNoise);
+  if (myShadowFilter != NULL) {
+    myShadowFilter->setPressureNoise(myPressureNoise);
+  }
+
+  // pressure samples per second and altitude noise in cm
+  double sampleRate = (myCalibrationCnt - 1) * 1000.0 / elapsed;
+  double heightPerPa = 100 * 44330.0 * 0.1902949 / PRESSURE_SEALEVEL
+                       * pow(myFilter.getSmoothedPressure() / PRESSURE_SEALEVEL, 0.1902949 - 1);
+  double heightNoise = myPressureNoise * heightPerPa;
+
+  // both IIR filters use the same factor ß, the noise power gain of
+  // IIR -> differentiation -> IIR is 2*((1-ß)/(1+ß))³, so
+  // σv = fs * σh * sqrt(2) * ((1-ß)/(1+ß))^(3/2)
+  double r = pow(myCalibrationTarget / (sampleRate * heightNoise * sqrt(2.0)), 2.0/3.0);
+  double factor = constrain((1 - r) / (1 + r), 0.0, 0.995);
+  setPressureSmoothingFactor(factor);
+  setVerticalSpeedSmoothingFactor(factor);
 }
 
+
 unsigned int VarioMS5611::getRunCount() {
   return myRunCnt;
 }
@@ -340,52 +592,36 @@ unsigned int VarioMS5611::getRunCount() {
 float VarioMS5611::getReadsPerSecond() {
   return myReadsPerSecond;
 }
+
+float VarioMS5611::getDutyCycle() {
+  return myDutyCycle;
+}
+
+float VarioMS5611::getTemperatureTrend() {
+  return myTemperatureTrend;
+}
 #endif
 
 double VarioMS5611::getSmoothedPressure(void) {
-  return mySmoothedPressureVal;
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  traceSampleAge();
+  #endif
+  return myFilter.getSmoothedPressure();
 }
 
 double VarioMS5611::getPressure(void) {
+  #ifdef VARIO_SAMPLE_AGE_TRACE
+  traceSampleAge();
+  #endif
   return myPressureVal;
 }
 
 int32_t VarioMS5611::readPressure(bool aCompensation)
 {
     uint32_t D1 = readRawPressure();
-
     uint32_t D2 = readRawTemperature();
-    int32_t dT = D2 - (uint32_t)myCompensationValues[4] * 256;
-
-    int64_t OFF = (int64_t)myCompensationValues[1] * 65536 + (int64_t)myCompensationValues[3] * dT / 128;
-    int64_t SENS = (int64_t)myCompensationValues[0] * 32768 + (int64_t)myCompensationValues[2] * dT / 256;
 
-    if (aCompensation)
-    {
-	int32_t TEMP = 2000 + ((int64_t) dT * myCompensationValues[5]) / 8388608;
-
-	myOFF2 = 0;
-	mySENS2 = 0;
-
-	if (TEMP < 2000)
-	{
-	    myOFF2 = 5 * ((TEMP - 2000) * (TEMP - 2000)) / 2;
-	    mySENS2 = 5 * ((TEMP - 2000) * (TEMP - 2000)) / 4;
-	}
-
-	if (TEMP < -1500)
-	{
-	    myOFF2 = myOFF2 + 7 * ((TEMP + 1500) * (TEMP + 1500));
-	    mySENS2 = mySENS2 + 11 * ((TEMP + 1500) * (TEMP + 1500)) / 2;
-	}
-
-	OFF = OFF - myOFF2;
-	SENS = SENS - mySENS2;
-    }
-
-    uint32_t P = (D1 * SENS / 2097152 - OFF) / 32768;
-
-    return P;
+    return calcTemperatureCompensatedPressure(D1, D2, aCompensation);
 }
 
 double VarioMS5611::getTemperature(void) {
@@ -395,23 +631,8 @@ double VarioMS5611::getTemperature(void) {
 double VarioMS5611::readTemperature(bool aCompensation)
 {
     uint32_t D2 = readRawTemperature();
-    int32_t dT = D2 - (uint32_t)myCompensationValues[4] * 256;
 
-    int32_t TEMP = 2000 + ((int64_t) dT * myCompensationValues[5]) / 8388608;
-
-    myTEMP2 = 0;
-
-    if (aCompensation) {
-      // second order compensation
-      if (TEMP < 2000) {
-        myTEMP2 = (dT * dT) / INT32_MAX;
-
-      }
-    }
-
-    TEMP = TEMP - myTEMP2;
-
-    return ((double)TEMP/100);
+    return ((double)calcTemperature(D2, aCompensation)/100);
 }
 
 double VarioMS5611::getReferenceHeight(void) {
@@ -435,25 +656,25 @@ double VarioMS5611::calcAltitude(double aPressure, double aSeaLevelPressure)
 uint16_t VarioMS5611::readRegister16(uint8_t reg)
 {
     uint16_t value;
-    Wire.beginTransmission(MS5611_ADDRESS);
+    myWire->beginTransmission(myAddress);
     #if ARDUINO >= 100
-        Wire.write(reg);
+        myWire->write(reg);
     #else
-        Wire.send(reg);
+        myWire->send(reg);
     #endif
-    Wire.endTransmission();
+    myWire->endTransmission();
 
-    Wire.beginTransmission(MS5611_ADDRESS);
-    Wire.requestFrom(MS5611_ADDRESS, 2);
-    while(!Wire.available()) {};
+    myWire->beginTransmission(myAddress);
+    myWire->requestFrom(myAddress, (uint8_t) 2);
+    while(!myWire->available()) {};
     #if ARDUINO >= 100
-        uint8_t vha = Wire.read();
-        uint8_t vla = Wire.read();
+        uint8_t vha = myWire->read();
+        uint8_t vla = myWire->read();
     #else
-        uint8_t vha = Wire.receive();
-        uint8_t vla = Wire.receive();
+        uint8_t vha = myWire->receive();
+        uint8_t vla = myWire->receive();
     #endif
-    Wire.endTransmission();
+    myWire->endTransmission();
 
     value = vha << 8 | vla;
 
@@ -464,33 +685,192 @@ uint16_t VarioMS5611::readRegister16(uint8_t reg)
 uint32_t VarioMS5611::readRegister24(uint8_t reg)
 {
     uint32_t value;
-    Wire.beginTransmission(MS5611_ADDRESS);
+    myWire->beginTransmission(myAddress);
     #if ARDUINO >= 100
-        Wire.write(reg);
+        myWire->write(reg);
     #else
-        Wire.send(reg);
+        myWire->send(reg);
     #endif
-    Wire.endTransmission();
+    myWire->endTransmission();
 
-    Wire.beginTransmission(MS5611_ADDRESS);
-    Wire.requestFrom(MS5611_ADDRESS, 3);
-    while(!Wire.available()) {};
+    myWire->beginTransmission(myAddress);
+    myWire->requestFrom(myAddress, (uint8_t) 3);
+    while(!myWire->available()) {};
     #if ARDUINO >= 100
-        uint8_t vxa = Wire.read();
-        uint8_t vha = Wire.read();
-        uint8_t vla = Wire.read();
+        uint8_t vxa = myWire->read();
+        uint8_t vha = myWire->read();
+        uint8_t vla = myWire->read();
     #else
-        uint8_t vxa = Wire.receive();
-        uint8_t vha = Wire.receive();
-        uint8_t vla = Wire.receive();
+        uint8_t vxa = myWire->receive();
+        uint8_t vha = myWire->receive();
+        uint8_t vla = myWire->receive();
     #endif
-    Wire.endTransmission();
+    myWire->endTransmission();
 
     value = ((int32_t)vxa << 16) | ((int32_t)vha << 8) | vla;
 
     return value;
 }
 
+#ifdef VARIO_BLACKBOX
+void VarioMS5611::recordBlackBox(void) {
+  if (myBlackBoxFrozen) {
+    return;
+  }
+  myBlackBox[myBlackBoxPos].time = mySampleTime;
+  myBlackBox[myBlackBoxPos].d1 = myRawPressureVal_D1;
+  myBlackBox[myBlackBoxPos].d2 = myRawTemperatureVal_D2;
+  if (++myBlackBoxPos >= VARIO_BLACKBOX_SIZE) {
+    myBlackBoxPos = 0;
+  }
+  if (myBlackBoxCnt < VARIO_BLACKBOX_SIZE) {
+    myBlackBoxCnt++;
+  }
+
+  // sensor fault: the MS5611 delivers 0, if the ADC is read before the conversion is finished
+  if (myRawPressureVal_D1 == 0 || myRawTemperatureVal_D2 == 0) {
+    myBlackBoxFrozen = true;
+  }
+  if (myBlackBoxTrigger > 0 && !myWarmUpPhase && abs(myFilter.getVerticalSpeed()) > myBlackBoxTrigger) {
+    myBlackBoxFrozen = true;
+  }
+}
+
+void VarioMS5611::freezeBlackBox(void) {
+  myBlackBoxFrozen = true;
+}
+
+void VarioMS5611::releaseBlackBox(void) {
+  myBlackBoxPos = 0;
+  myBlackBoxCnt = 0;
+  myBlackBoxFrozen = false;
+}
+
+bool VarioMS5611::isBlackBoxFrozen(void) {
+  return myBlackBoxFrozen;
+}
+
+void VarioMS5611::setBlackBoxTrigger(int aVerticalSpeedLimit) {
+  myBlackBoxTrigger = aVerticalSpeedLimit;
+}
+
+size_t VarioMS5611::dumpBlackBox(Print& aOut) {
+  uint8_t buf[12];
+  size_t len = 0;
+
+  buf[0] = 'V';
+  buf[1] = 'B';
+  buf[2] = 'B';
+  buf[3] = VARIO_BLACKBOX_FORMAT;
+  buf[4] = myBlackBoxCnt;
+  buf[5] = 0;
+  len += aOut.write(buf, 6);
+  for (uint8_t i = 0; i < 6; i++) {
+    buf[2*i] = myCompensationValues[i];
+    buf[2*i+1] = myCompensationValues[i] >> 8;
+  }
+  len += aOut.write(buf, 12);
+
+  // filter settings, to replay the samples with the same setup
+  buf[0] = (myDoSecondOrderCompensation ? 0x01 : 0) | (getAdaptivePressureSmoothing() ? 0x02 : 0);
+  buf[1] = getVerticalSpeedMode();
+  len += aOut.write(buf, 2);
+  float settings[5] = {
+    (float) getPressureSmoothingFactor(), (float) getVerticalSpeedSmoothingFactor(),
+    (float) getVerticalAccelerationSmoothingFactor(), (float) getAdaptivePressureSmoothingMinFactor(),
+    (float) getAdaptivePressureSmoothingMaxFactor()
+  };
+  for (uint8_t i = 0; i < 5; i++) {
+    uint32_t raw;
+    memcpy(&raw, &settings[i], sizeof(raw));
+    buf[0] = raw;
+    buf[1] = raw >> 8;
+    buf[2] = raw >> 16;
+    buf[3] = raw >> 24;
+    len += aOut.write(buf, 4);
+  }
+
+  // oldest sample first
+  uint8_t pos = (myBlackBoxPos + VARIO_BLACKBOX_SIZE - myBlackBoxCnt) % VARIO_BLACKBOX_SIZE;
+  for (uint8_t i = 0; i < myBlackBoxCnt; i++) {
+    uint32_t time = myBlackBox[pos].time;
+    uint32_t d1 = myBlackBox[pos].d1;
+    uint32_t d2 = myBlackBox[pos].d2;
+    buf[0] = time;
+    buf[1] = time >> 8;
+    buf[2] = time >> 16;
+    buf[3] = time >> 24;
+    buf[4] = d1;
+    buf[5] = d1 >> 8;
+    buf[6] = d1 >> 16;
+    buf[7] = d2;
+    buf[8] = d2 >> 8;
+    buf[9] = d2 >> 16;
+    len += aOut.write(buf, 10);
+    if (++pos >= VARIO_BLACKBOX_SIZE) {
+      pos = 0;
+    }
+  }
+  return len;
+}
+#endif
+
+#ifdef VARIO_SAMPLE_AGE_TRACE
+void VarioMS5611::traceSampleAge(void) {
+  if (myTraceConsumed) {
+    // only the first access to a sample is traced
+    return;
+  }
+  myTraceConsumed = true;
+  unsigned long now = micros();
+  unsigned long age = now - myTraceSampleStart;
+  myTraceConversionLatency = myTraceRead - myTraceSampleStart;
+  myTraceProcessingLatency = myTracePublished - myTraceRead;
+  myTraceConsumerLatency = now - myTracePublished;
+  uint8_t bin = min(age / (VARIO_SAMPLE_AGE_BIN_WIDTH * 1000UL), (unsigned long)(VARIO_SAMPLE_AGE_BINS - 1));
+  if (mySampleAgeHistogram[bin] < UINT16_MAX) {
+    mySampleAgeHistogram[bin]++;
+  }
+  if (age > myMaxSampleAge) {
+    myMaxSampleAge = age;
+  }
+  mySampleAge = age;
+}
+
+unsigned long VarioMS5611::getSampleAge(void) {
+  return mySampleAge;
+}
+
+unsigned long VarioMS5611::getMaxSampleAge(void) {
+  return myMaxSampleAge;
+}
+
+unsigned long VarioMS5611::getConversionLatency(void) {
+  return myTraceConversionLatency;
+}
+
+unsigned long VarioMS5611::getProcessingLatency(void) {
+  return myTraceProcessingLatency;
+}
+
+unsigned long VarioMS5611::getConsumerLatency(void) {
+  return myTraceConsumerLatency;
+}
+
+uint16_t VarioMS5611::getSampleAgeHistogram(uint8_t aBin) {
+  return aBin < VARIO_SAMPLE_AGE_BINS ? mySampleAgeHistogram[aBin] : 0;
+}
+
+void VarioMS5611::resetSampleAgeHistogram(void) {
+  memset(mySampleAgeHistogram, 0, sizeof(mySampleAgeHistogram));
+  mySampleAge = 0;
+  myMaxSampleAge = 0;
+  myTraceConversionLatency = 0;
+  myTraceProcessingLatency = 0;
+  myTraceConsumerLatency = 0;
+}
+#endif
+
 void VarioMS5611::run() {
   triggerReadValues();
 }
@@ -34,6 +34,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * * an interface to manage smoothing factors for pressure and variometer values
  * * an non blocking data aquisition method provided by using cooperative run() method, for sampling the pressure and temperature data
  * * some extra methods to get statistical measure value information
+ * * a barograph logger (VarioBarograph) writing pressure altitude records to a pluggable storage sink
+ * * an optional black box buffer (VARIO_BLACKBOX) of the recent raw samples, frozen on anomalies
+ * * an optional shadow filter chain (VarioFilter) for live A/B comparison of filter setups
+ * * parameterized flight scenarios (VarioScenario) generating input data for a simulated MS5611
+ * * an optional end-to-end sample age tracing (VARIO_SAMPLE_AGE_TRACE) from conversion start to consumer
+ * * a runtime tuning channel (VarioTuning) setting the oversampling rate, smoothing factors and compensation mode by binary commands
  *
  * \section signal_sec Signal quality
  * Using this library a oversampling rate of about 160000 samples/second can be reached. With according smoothing factors (~0.93) 
@@ -73,11 +79,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // V0.1.1 : fixed minor temperature bug, and "removed" some extended / not needed code parts to 
 //          reduce memory usage
 // V0.1.2 : bug fix: relative altitude is reseted due to counter overflow
+// V0.2.0 : added VarioBarograph, a double buffered barograph logger with pluggable sinks
+//          added black box buffer of raw samples (VARIO_BLACKBOX)
+//          added self heating monitor and conversion duty cycle limit
+//          added startup noise calibration of the smoothing factors
+//          added vertical acceleration
+//          added Savitzky-Golay vertical speed mode (VARIO_SG_FILTER)
+//          added innovation adaptive pressure smoothing
+//          moved the filter chain to VarioFilter, added shadow filter chain
+//          readPressure()/readTemperature() use the same calculation as run(), added selfTest()
+//          bug fix: 32 bit overflow in the second order temperature compensation
+//          added VarioScenario flight scenarios, processRawSample() and begin() without MS5611
+//          to feed simulated samples
+//          added end-to-end sample age tracing (VARIO_SAMPLE_AGE_TRACE)
+//          support of multiple instances: configurable I2C address and bus, no shared state,
+//          added host benchmark of many simulated instances (extras/FleetBench.cpp)
+//          added VarioTuning, a binary command channel to set the parameters at runtime
 
 #ifndef VARIO_MS5611_h
 #define VARIO_MS5611_h
 
-#define VARIO_MS5611_VERSION "V0.1.2"
+#define VARIO_MS5611_VERSION "V0.2.0"
 
 #if ARDUINO >= 100
 #include "Arduino.h"
@@ -85,6 +107,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "WProgram.h"
 #endif
 
+#include <Wire.h>
+
+#include "VarioFilter.h"
+
 #define MS5611_ADDRESS                (0x77)
 
 #define MS5611_CMD_ADC_READ           (0x00)
@@ -95,6 +121,29 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define PRESSURE_SEALEVEL         101325
 
+#ifdef VARIO_BLACKBOX
+/// number of raw samples kept in the black box buffer (12 bytes RAM per sample, max. 255)
+#ifndef VARIO_BLACKBOX_SIZE
+#define VARIO_BLACKBOX_SIZE       32
+#endif
+#if VARIO_BLACKBOX_SIZE > 255
+#error "VARIO_BLACKBOX_SIZE has to be <= 255"
+#endif
+/// format version of the black box dump, see VarioMS5611::dumpBlackBox()
+#define VARIO_BLACKBOX_FORMAT     2
+#endif
+
+#ifdef VARIO_SAMPLE_AGE_TRACE
+/// number of bins of the sample age histogram
+#ifndef VARIO_SAMPLE_AGE_BINS
+#define VARIO_SAMPLE_AGE_BINS     16
+#endif
+/// width of one bin of the sample age histogram in ms
+#ifndef VARIO_SAMPLE_AGE_BIN_WIDTH
+#define VARIO_SAMPLE_AGE_BIN_WIDTH 4
+#endif
+#endif
+
 /**
  * over sampling rates used by MS5611 internally
  */
@@ -116,6 +165,7 @@ typedef enum
 } vario_value_t;
 
 
+
 /// VarioMS5611 non-blocking data aquisition, for large OSR rates and accurate pressure, height and variometer values
 /**
  * VarioMS5611 provides 
@@ -131,8 +181,22 @@ class VarioMS5611
     public:
 
 	/// for initialzation
-	/** has to be called once before the VarioMS5611 instance can be used */
-	bool begin(ms5611_osr_t aSamplingRate = MS5611_ULTRA_HIGH_RES );
+	/** has to be called once before the VarioMS5611 instance can be used
+	 * @param aSamplingRate oversampling rate of the MS5611
+	 * @param aAddress I2C address of the MS5611 (0x77 or 0x76, depending on the CSB pin)
+	 * @param aWire I2C bus the MS5611 is connected to
+	 */
+	bool begin(ms5611_osr_t aSamplingRate = MS5611_ULTRA_HIGH_RES, uint8_t aAddress = MS5611_ADDRESS, TwoWire& aWire = Wire);
+
+	/// for initialzation without a MS5611, e.g. for simulated (see VarioScenario) or recorded samples
+	/** the samples have to be fed by processRawSample(), the filter is set to the first sample.
+	 * run() does not read any values and the readXXX() methods return the values of the
+	 * last processed sample.
+	 * @param aCalibration calibration values C1-C6 (e.g. of a black box dump, see dumpBlackBox())
+	 * @param aWarmUp if false, the warm-up phase (the first 50 samples without vertical speed and
+	 *        with the noise calibration) is skipped, e.g. to replay a short black box dump
+	 */
+	bool begin(const uint16_t* aCalibration, bool aWarmUp = true);
 
 	/// read the raw tempeature value (blocking)
 	/** returns the raw temperature value given by the MS5611 chip 
@@ -211,13 +275,23 @@ class VarioMS5611
 	 */
         int getVerticalSpeed(void);
 
+	/// get the vertical acceleration value in cm/s² (non-blocking)
+	/**
+	 * returns the vertical acceleration in cm/s², calculated in the same pass as the vertical speed
+	 * from the not truncated smoothed vertical speed and the time stamps of the pressure samples.
+	 * The value is smoothed by an additional IIR Low Pass Filter (see setVerticalAccelerationSmoothingFactor()),
+	 * which adds a delay of about ß/(1-ß) pressure samples.
+	 * getXXX() means non-blocking get of pre fetched values/calculations/smoothings within run()
+	 */
+	double getVerticalAcceleration(void);
+
 	/// calculate the absolute altitude of the given pressure
 	/**
 	 * returns the calculated absolute altitude in meter, for the given pressure
 	 * @aPressure pressure in Pa for which the altitude has to be calculated
 	 * @aSeaLevelPressure reference pressure in Pa the altitude has to be related to
 	 */
-	double calcAltitude(double aPressure, double aSeaLevelPressure = 101325);
+	static double calcAltitude(double aPressure, double aSeaLevelPressure = 101325);
 
 
 	/// calculate the relative altitude of the given pressure
@@ -243,6 +317,34 @@ class VarioMS5611
 	 */
         double getVerticalSpeedSmoothingFactor(void);
 
+	/// set the calculation mode of the vertical speed (variometer) value
+	/**
+	 * VARIO_MODE_IIR differentiates the smoothed pressure and smooths the result by a IIR Low Pass Filter.
+	 * VARIO_MODE_SAVITZKY_GOLAY (needs VARIO_SG_FILTER) fits a polynomial of the given order to the last
+	 * aWindowLength altitude samples (of the smoothed pressure) and uses the derivative in the center of the
+	 * window, instead of the IIR Low Pass Filter of the vertical speed. This preserves peaks of the climbing
+	 * rate better and has a fixed delay of (aWindowLength-1)/2 pressure samples. A pressure smoothing
+	 * factor of 0 gives a pure Savitzky-Golay differentiator.
+	 * returns false, if the mode is not available or the parameters are not valid
+	 * @param aWindowLength odd number of samples 5...VARIO_SG_MAX_WINDOW
+	 * @param aPolynomialOrder 1...4, the derivative of the order 1 and 2, as well as 3 and 4 are identical
+	 */
+	bool setVerticalSpeedMode(vario_mode_t aMode, uint8_t aWindowLength = 9, uint8_t aPolynomialOrder = 2);
+
+	/// get the calculation mode of the vertical speed (variometer) value
+	vario_mode_t getVerticalSpeedMode(void);
+
+	/// set the IIR smoothing factor for the vertical acceleration value
+	/**
+	 * for smoothing the vertical acceleration value a IIR Low Pass Filter is used. 
+	 * factor near to 1 means more smoothing 
+	 * factor near to 0 means less smoothing
+	 */
+	void setVerticalAccelerationSmoothingFactor(double aFactor);
+
+	/// get the IIR smoothing factor for the vertical acceleration value
+	double getVerticalAccelerationSmoothingFactor(void);
+
 	/// set the IIR smoothing factor for the pressure value
 	/**
 	 * for smoothing the pressure value a IIR Low Pass Filter is used. 
@@ -259,6 +361,61 @@ class VarioMS5611
 	 */
 	double getPressureSmoothingFactor(void);
 
+	/// enable the innovation adaptive smoothing of the pressure value
+	/**
+	 * in adaptive mode the IIR smoothing factor of the pressure value is scaled per sample, based on
+	 * the innovation (difference between the new pressure value and the smoothed pressure value) relative
+	 * to a running estimate of the pressure noise. Innovations within the noise (< 1 sigma) use aMaxFactor
+	 * (heavy smoothing in calm air), innovations > 4 sigma (real pressure changes, e.g. in thermals) use
+	 * aMinFactor (fast response), in between the factor is interpolated linearly.
+	 * In adaptive mode the factor set by setPressureSmoothingFactor() is not used.
+	 * @param aMinFactor lower bound of the smoothing factor
+	 * @param aMaxFactor upper bound of the smoothing factor
+	 */
+	void setAdaptivePressureSmoothing(bool aEnable, double aMinFactor = 0.5, double aMaxFactor = 0.95);
+
+	/// returns true if the innovation adaptive smoothing of the pressure value is enabled
+	bool getAdaptivePressureSmoothing(void);
+
+	/// get the lower bound of the innovation adaptive smoothing factor (aMinFactor of setAdaptivePressureSmoothing())
+	double getAdaptivePressureSmoothingMinFactor(void);
+
+	/// get the upper bound of the innovation adaptive smoothing factor (aMaxFactor of setAdaptivePressureSmoothing())
+	double getAdaptivePressureSmoothingMaxFactor(void);
+
+	/// get the IIR smoothing factor used for the last pressure value
+	/** in adaptive mode this is the factor calculated for the last sample, otherwise the
+	 * factor set by setPressureSmoothingFactor()
+	 */
+	double getEffectivePressureSmoothingFactor(void);
+
+	/// enable the startup noise calibration for the given target vario sigma in cm/s
+	/**
+	 * during the warm-up phase (first 100 run()'s after begin()) the pressure noise of the MS5611
+	 * is measured at the configured OSR and sample rate. At the end of the warm-up phase, the pressure
+	 * and vertical speed smoothing factors are derived, so that the standard deviation of the
+	 * vertical speed in calm air reaches the given target. This overrides the smoothing factors
+	 * set before. Has to be called after begin(), 0 (default) disables the calibration.
+	 */
+	void setNoiseCalibration(double aTargetVerticalSpeedSigma);
+
+	/// get the pressure noise (standard deviation in Pa) measured by the startup noise calibration
+	/** returns 0 if no calibration has been done */
+	double getPressureNoise(void);
+
+	/// set a shadow filter chain, running alongside the production filter chain
+	/**
+	 * the shadow filter is fed with the same compensated pressure samples as the filter chain
+	 * providing getSmoothedPressure(), getVerticalSpeed() and getVerticalAcceleration(), but is
+	 * configured independently via its own VarioFilter methods. This allows a live A/B comparison
+	 * of two filter setups in one flight, at the cost of one extra filter pass per sample.
+	 * The VarioFilter instance is owned by the caller, NULL removes the shadow filter.
+	 */
+	void setShadowFilter(VarioFilter* aFilter);
+
+	/// get the shadow filter chain, NULL if not set
+	VarioFilter* getShadowFilter(void);
+
 	/// get the reference height (stored at initialization)
 	/**
 	 * get the reference height (stored at initialization)
@@ -283,6 +440,20 @@ class VarioMS5611
 	void run();
 
 
+	/// process a raw pressure and temperature sample, not read from the MS5611
+	/**
+	 * the sample is processed like a sample read within run() (compensation, filtering, ...).
+	 * This allows to replay recorded raw samples (e.g. a black box dump) or to feed samples of
+	 * a simulated MS5611 (see VarioScenario and begin(const uint16_t*)). 
+	 * @param aRawPressure raw pressure value D1
+	 * @param aRawTemperature raw temperature value D2
+	 * @param aTime time stamp of the sample in ms
+	 */
+	void processRawSample(uint32_t aRawPressure, uint32_t aRawTemperature, unsigned long aTime);
+
+	/// get the calibration values C1-C6 read from the MS5611 PROM
+	const uint16_t* getCalibrationValues(void);
+
 	/// get the number of reads of the pressure and temperature values
 	/** returns the number of read of the pressure and temperature values (1 means both are read one time)
 	 */
@@ -305,7 +476,106 @@ class VarioMS5611
 	 * The default setting is false
 	 */
 	void setSecondOrderCompenstation(bool aDoCompensate);
+
+	/// check the temperature and pressure calculation
+	/** returns true, if the calculation of the temperature and the compensated pressure delivers the
+	 * expected results for the datasheet example (20.07°C) and for vectors at 10°C and -20°C, where
+	 * the second order temperature compensation and its low temperature part apply. Each vector is
+	 * checked with and without second order compensation. Can be used to detect compiler/platform
+	 * issues of the 64 bit integer arithmetic. The calibration values of the sensor are not affected.
+	 */
+	bool selfTest(void);
+
+	/// set the maximal conversion duty cycle of the MS5611 (0.1 - 1.0)
+	/** back-to-back conversions at high OSR warm up the MS5611 die (self heating), which results in
+	 * a slow pressure drift through the temperature compensation. A duty cycle < 1.0 inserts idle
+	 * time after each conversion, so that the MS5611 is converting only the given part of the time.
+	 * The default setting is 1.0 (no idle time)
+	 */
+	void setMaxDutyCycle(float aDutyCycle);
+
+	/// get the maximal conversion duty cycle of the MS5611
+	float getMaxDutyCycle(void);
+
+	#ifdef VARIO_EXTENDED_INTERFACE
+	/// get the measured conversion duty cycle of the MS5611
+	/** returns the part of the time (0.0 - 1.0) the MS5611 was converting within the last second
+	 */
+	float getDutyCycle(void);
+
+	/// get the smoothed trend of the sensor temperature in °C/min
+	/** a positive trend at a high duty cycle, while the ambient temperature is stable,
+	 * indicates self heating of the MS5611 die
+	 */
+	float getTemperatureTrend(void);
+	#endif
+
+	#ifdef VARIO_SAMPLE_AGE_TRACE
+	/// get the age in µs of the last consumed sample
+	/**
+	 * the age of a sample is the time from the start of its pressure conversion till the first
+	 * access by getPressure(), getSmoothedPressure(), getVerticalSpeed() or getVerticalAcceleration().
+	 * Only the first access to each sample is traced, later accesses read the same (older) value.
+	 */
+	unsigned long getSampleAge(void);
+
+	/// get the maximal age in µs of a consumed sample since the last resetSampleAgeHistogram()
+	unsigned long getMaxSampleAge(void);
+
+	/// get the time in µs from the start of the pressure conversion till the ADC read, of the last consumed sample
+	unsigned long getConversionLatency(void);
+
+	/// get the time in µs from the ADC read till the publication (after compensation and filtering), of the last consumed sample
+	unsigned long getProcessingLatency(void);
+
+	/// get the time in µs from the publication till the first access by the consumer, of the last consumed sample
+	unsigned long getConsumerLatency(void);
+
+	/// get the number of consumed samples with an age within the given bin
+	/** bin n counts the ages from n*VARIO_SAMPLE_AGE_BIN_WIDTH till (n+1)*VARIO_SAMPLE_AGE_BIN_WIDTH ms,
+	 * the last bin (VARIO_SAMPLE_AGE_BINS-1) counts all larger ages
+	 */
+	uint16_t getSampleAgeHistogram(uint8_t aBin);
+
+	/// reset the sample age histogram and the latency values
+	void resetSampleAgeHistogram(void);
+	#endif
+
+	#ifdef VARIO_BLACKBOX
+	/// freeze the black box buffer of the raw samples
+	/** the buffer keeps the last VARIO_BLACKBOX_SIZE raw D1/D2 samples with its time stamps,
+	 * till it is released by releaseBlackBox(). Besides this method, the buffer is frozen
+	 * automatically, if a sensor fault (raw value 0) is read or the trigger set by
+	 * setBlackBoxTrigger() is hit.
+	 */
+	void freezeBlackBox(void);
+
+	/// release a frozen black box buffer and restart recording of raw samples
+	void releaseBlackBox(void);
+
+	/// returns true if the black box buffer is frozen
+	bool isBlackBoxFrozen(void);
+
+	/// set the vertical speed limit in cm/s, freezing the black box buffer if exceeded
+	/** 0 (default) disables this trigger */
+	void setBlackBoxTrigger(int aVerticalSpeedLimit);
+
+	/// dump the black box buffer in a compact binary format
+	/**
+	 * returns the number of bytes written. The format (all values little endian) is:
+	 * * header: 'V', 'B', 'B', VARIO_BLACKBOX_FORMAT, uint16_t number of samples,
+	 *   6 x uint16_t calibration values C1-C6 of the MS5611 PROM
+	 * * settings: uint8_t flags (bit 0: second order compensation, bit 1: adaptive pressure smoothing),
+	 *   uint8_t vertical speed mode (vario_mode_t), 5 x float smoothing factors: pressure, vertical speed,
+	 *   vertical acceleration, adaptive min. and max. factor
+	 * * samples, oldest first: uint32_t time stamp in ms, 24 bit D1, 24 bit D2
+	 */
+	size_t dumpBlackBox(Print& aOut);
+	#endif
     private:
+	uint8_t myAddress;
+	TwoWire* myWire;
+	unsigned long myNextRead;
 	bool myDoSecondOrderCompensation;
 	bool myWarmUpPhase;
         uint32_t myRunCnt;
@@ -313,22 +583,38 @@ class VarioMS5611
         unsigned int myReadsCnt;
         unsigned long myReadsCntTimer;
         float myReadsPerSecond;
+        unsigned int myConversionTime;
+        int32_t myTrendTemperatureVal;
+        float myDutyCycle;
+        float myTemperatureTrend;
         #endif
-	double myPressureSmoothingFactor;
+	float myMaxDutyCycle;
+	uint8_t myIdleTime;
+	VarioFilter myFilter;
+	VarioFilter* myShadowFilter;
+	double myCalibrationTarget;
+	double myCalibrationMean;
+	double myCalibrationM2;
+	double myPressureNoise;
+	uint16_t myCalibrationCnt;
+	int32_t myCalibrationLastPressure;
+	unsigned long myCalibrationStart;
+	void calibrateNoise(void);
+	void initState(void);
+	void startAcquisition(void);
+	void finishWarmUp(void);
+	void processPressureSample(void);
+	void finishNoiseCalibration(void);
 	double myReferenceHeight;
 	vario_value_t myPendingValueType;
 	boolean triggerReadValues(vario_value_t aRequestType = NONE);
-	int myVerticalSpeed;
-	double myVerticalSpeedSmoothingFactor;
-	void calcFilter(void);
-	void calcVerticalSpeed(void);
-        int32_t calcTemperature(uint32_t aRawTemperature);
-	int32_t calcTemperatureCompensatedPressure(uint32_t aRawPressure, uint32_t aRawTemperature);
+	unsigned long mySampleTime;
+        int32_t calcTemperature(uint32_t aRawTemperature, bool aCompensation);
+	int32_t calcTemperatureCompensatedPressure(uint32_t aRawPressure, uint32_t aRawTemperature, bool aCompensation);
 	uint16_t myCompensationValues[6];
         uint32_t myRawPressureVal_D1;
         uint32_t myRawTemperatureVal_D2;
         int32_t myPressureVal;
-        double  mySmoothedPressureVal;
         int32_t myTemperatureVal;
 
 	uint8_t myct;
@@ -336,6 +622,34 @@ class VarioMS5611
 	int32_t myTEMP2;
 	int64_t myOFF2, mySENS2;
 
+	#ifdef VARIO_SAMPLE_AGE_TRACE
+	unsigned long myTraceConversionStart;
+	unsigned long myTraceSampleStart;
+	unsigned long myTraceRead;
+	unsigned long myTracePublished;
+	bool myTraceConsumed;
+	unsigned long mySampleAge;
+	unsigned long myMaxSampleAge;
+	unsigned long myTraceConversionLatency;
+	unsigned long myTraceProcessingLatency;
+	unsigned long myTraceConsumerLatency;
+	uint16_t mySampleAgeHistogram[VARIO_SAMPLE_AGE_BINS];
+	void traceSampleAge(void);
+	#endif
+
+	#ifdef VARIO_BLACKBOX
+	struct {
+	  uint32_t time;
+	  uint32_t d1;
+	  uint32_t d2;
+	} myBlackBox[VARIO_BLACKBOX_SIZE];
+	uint8_t myBlackBoxPos;
+	uint8_t myBlackBoxCnt;
+	bool myBlackBoxFrozen;
+	int myBlackBoxTrigger;
+	void recordBlackBox(void);
+	#endif
+
 	void reset(void);
 	void readPROM(void);
 
@@ -0,0 +1,187 @@
+/*
+Load.ino - Application load interference benchmark for the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The cooperative run() method only samples, if it is called often enough. This sketch runs
+// run() in the loop next to configurable foreground workloads and reports for each workload,
+// how the achieved reads per second, the sample jitter and the vario noise degrade.
+// The sensor has to lay still on the desk during the benchmark.
+
+#include <Wire.h>
+#include <VarioMS5611.h>
+
+#define BAUD              115200
+#define PHASE_DURATION    30000     // ms per workload
+#define DISPLAY_ADDRESS   0x3C      // I2C address used for the simulated I2C traffic
+
+typedef struct {
+  const char* name;
+  uint8_t uartBytes;        // bytes printed per UART line
+  uint16_t uartPeriod;      // ms between two UART lines (0 = no UART output)
+  uint16_t displayTime;     // ms blocking CPU time per display update
+  uint16_t displayPeriod;   // ms between two display updates (0 = no display)
+  uint8_t i2cBytes;         // bytes per I2C transfer to DISPLAY_ADDRESS
+  uint16_t i2cPeriod;       // ms between two I2C transfers (0 = no I2C traffic)
+} workload_t;
+
+const workload_t workloads[] = {
+  // name         uart      display    i2c
+  { "idle",        0,   0,   0,   0,   0,   0 },
+  { "uart",       80,  20,   0,   0,   0,   0 },
+  { "display",     0,   0,  15, 100,   0,   0 },
+  { "i2c",         0,   0,   0,   0,  32,  50 },
+  { "all",        80,  20,  15, 100,  32,  50 },
+};
+const uint8_t workloadCnt = sizeof(workloads) / sizeof(workloads[0]);
+
+VarioMS5611 varioMS5611;
+
+uint8_t phase = 0;
+unsigned long phaseStart;
+unsigned long lastUart, lastDisplay, lastI2C;
+unsigned int lastRunCnt;
+uint32_t lastRawPressure;
+unsigned long lastSample;
+unsigned long samples;
+double intervalSum, intervalSum2;
+unsigned long intervalMax;
+unsigned long varioCnt;
+double varioSum, varioSum2;
+
+void startPhase() {
+  phaseStart = millis();
+  lastUart = lastDisplay = lastI2C = phaseStart;
+  lastRunCnt = varioMS5611.getRunCount();
+  lastRawPressure = varioMS5611.getRawPressure();
+  lastSample = micros();
+  samples = 0;
+  intervalSum = intervalSum2 = 0;
+  intervalMax = 0;
+  varioCnt = 0;
+  varioSum = varioSum2 = 0;
+}
+
+void reportPhase() {
+  double duration = (millis() - phaseStart) / 1000.0;
+  double intervalMean = samples > 0 ? intervalSum / samples : 0;
+  double jitter = samples > 1 ? sqrt(max(0.0, intervalSum2 / samples - intervalMean * intervalMean)) : 0;
+  double varioMean = varioCnt > 0 ? varioSum / varioCnt : 0;
+  double varioSigma = varioCnt > 1 ? sqrt(max(0.0, varioSum2 / varioCnt - varioMean * varioMean)) : 0;
+
+  Serial.println();
+  Serial.print("workload: ");
+  Serial.print(workloads[phase].name);
+  Serial.print(" reads/s: ");
+  Serial.print(samples / duration);
+  Serial.print(" interval[ms]: ");
+  Serial.print(intervalMean / 1000.0);
+  Serial.print(" jitter[ms]: ");
+  Serial.print(jitter / 1000.0);
+  Serial.print(" max.interval[ms]: ");
+  Serial.print(intervalMax / 1000.0);
+  Serial.print(" vario.sigma[cm/s]: ");
+  Serial.print(varioSigma);
+  Serial.println();
+}
+
+void runWorkload(const workload_t& aLoad, unsigned long aNow) {
+  if (aLoad.uartPeriod > 0 && aNow - lastUart >= aLoad.uartPeriod) {
+    // Serial.print() blocks, if the TX buffer is full
+    // "# ", the x's and CR LF of println() add up to uartBytes
+    Serial.print("# ");
+    for (uint8_t i = 2; i < aLoad.uartBytes - 2; i++) {
+      Serial.write('x');
+    }
+    Serial.println();
+    lastUart = aNow;
+  }
+  if (aLoad.displayPeriod > 0 && aNow - lastDisplay >= aLoad.displayPeriod) {
+    // rendering a display frame, blocking the loop
+    delay(aLoad.displayTime);
+    lastDisplay = aNow;
+  }
+  if (aLoad.i2cPeriod > 0 && aNow - lastI2C >= aLoad.i2cPeriod) {
+    // other I2C traffic on the same bus
+    Wire.beginTransmission(DISPLAY_ADDRESS);
+    for (uint8_t i = 0; i < aLoad.i2cBytes; i++) {
+      Wire.write(i);
+    }
+    Wire.endTransmission();
+    lastI2C = aNow;
+  }
+}
+
+void setup()
+{
+  Serial.begin(BAUD);
+  Serial.println("# VarioMS5611 application load benchmark ... ");
+
+  while(!varioMS5611.begin(MS5611_ULTRA_HIGH_RES))
+  {
+    Serial.println("# waiting for varioMS5611");
+    delay(500);
+  }
+  varioMS5611.setVerticalSpeedSmoothingFactor(0.92);
+  varioMS5611.setPressureSmoothingFactor(0.93);
+
+  // warm-up phase of the sensor
+  while (varioMS5611.getRunCount() < 200) {
+    varioMS5611.run();
+  }
+  startPhase();
+}
+
+void loop()
+{
+  varioMS5611.run();
+
+  unsigned int runCnt = varioMS5611.getRunCount();
+  if (runCnt != lastRunCnt) {
+    // a new pressure or temperature value has been read
+    unsigned long now = micros();
+    unsigned long interval = now - lastSample;
+    intervalSum += interval;
+    intervalSum2 += (double) interval * interval;
+    if (interval > intervalMax) {
+      intervalMax = interval;
+    }
+    samples++;
+    lastSample = now;
+    lastRunCnt = runCnt;
+  }
+
+  uint32_t rawPressure = varioMS5611.getRawPressure();
+  if (rawPressure != lastRawPressure) {
+    // the vario value is only updated by a pressure read
+    int vario = varioMS5611.getVerticalSpeed();
+    varioSum += vario;
+    varioSum2 += (double) vario * vario;
+    varioCnt++;
+    lastRawPressure = rawPressure;
+  }
+
+  unsigned long now = millis();
+  if (phase < workloadCnt) {
+    runWorkload(workloads[phase], now);
+    if (now - phaseStart > PHASE_DURATION) {
+      reportPhase();
+      phase++;
+      startPhase();
+    }
+  }
+}
@@ -19,8 +19,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <Wire.h>
 #include <VarioMS5611.h>
+#include <VarioTuning.h>
 
 VarioMS5611 varioMS5611;
+// parameters can be changed at runtime by commands sent via Serial, see extras/TuningCommand.cpp
+VarioTuning varioTuning(varioMS5611, Serial, Serial);
 
 void setup() 
 {
@@ -35,12 +38,13 @@ void setup()
   varioMS5611.setOversampling(MS5611_ULTRA_HIGH_RES);
   varioMS5611.setVerticalSpeedSmoothingFactor(0.92);
   varioMS5611.setPressureSmoothingFactor(0.93);
-
+  varioTuning.begin();
 }
 
 void loop()
 {
   varioMS5611.run();
+  varioTuning.run();
 
   static unsigned long lastTime = 0;
   unsigned long now;
@@ -0,0 +1,177 @@
+/*
+VarioScenario.cpp - Class definition file for the flight scenarios of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <math.h>
+
+#include "VarioMS5611.h"
+#include "VarioScenario.h"
+
+// integration step in ms
+#define SCENARIO_STEP   10
+// time in s before the flight profile starts
+#define SCENARIO_LEAD   10.0
+
+VarioScenario::VarioScenario() {
+  myClimbRate = 1.0;
+  myEntryTime = 5.0;
+  myDuration = 60.0;
+  myTurbulenceSigma = 0.0;
+  myTurbulenceTime = 1.0;
+  myWeatherDrift = 0.0;
+  myTemperatureAmplitude = 0.0;
+  myTemperaturePeriod = 600.0;
+  begin(VARIO_SCENARIO_STATIC);
+}
+
+void VarioScenario::begin(vario_scenario_t aScenario, double aStartAltitude, double aTemperature, uint32_t aSeed) {
+  myScenario = aScenario;
+  myStartAltitude = aStartAltitude;
+  myStartTemperature = aTemperature;
+  myAltitude = aStartAltitude;
+  myVerticalSpeed = 0.0;
+  myGust = 0.0;
+  myTime = 0;
+  myRandom = aSeed != 0 ? aSeed : 1;
+}
+
+void VarioScenario::setClimbRate(double aRate) {
+  myClimbRate = fabs(aRate);
+}
+
+void VarioScenario::setEntryTime(double aTime) {
+  myEntryTime = aTime;
+}
+
+void VarioScenario::setDuration(double aTime) {
+  myDuration = aTime;
+}
+
+void VarioScenario::setTurbulence(double aSigma, double aCorrelationTime) {
+  myTurbulenceSigma = aSigma;
+  myTurbulenceTime = aCorrelationTime > 0 ? aCorrelationTime : 1.0;
+}
+
+void VarioScenario::setWeatherDrift(double aDrift) {
+  myWeatherDrift = aDrift;
+}
+
+void VarioScenario::setTemperatureSwing(double aAmplitude, double aPeriod) {
+  myTemperatureAmplitude = aAmplitude;
+  myTemperaturePeriod = aPeriod > 0 ? aPeriod : 600.0;
+}
+
+// smooth (raised cosine) ramp from 0 to 1 within aRampTime seconds
+static double ramp(double aTime, double aRampTime) {
+  if (aTime <= 0) {
+    return 0.0;
+  }
+  if (aTime >= aRampTime) {
+    return 1.0;
+  }
+  return 0.5 - 0.5 * cos(M_PI * aTime / aRampTime);
+}
+
+double VarioScenario::calcProfileSpeed(double aTime) {
+  double t = aTime - SCENARIO_LEAD;
+  switch (myScenario) {
+    case VARIO_SCENARIO_THERMAL:
+      // entry, climb for myDuration, exit
+      return myClimbRate * (ramp(t, myEntryTime) - ramp(t - myEntryTime - myDuration, myEntryTime));
+    case VARIO_SCENARIO_SINK:
+      return -myClimbRate;
+    case VARIO_SCENARIO_TAKEOFF_LANDING:
+      // climb, cruise and descent, each for myDuration
+      return myClimbRate * (ramp(t, myEntryTime) - ramp(t - myDuration, myEntryTime)
+                          - ramp(t - 2 * myDuration, myEntryTime) + ramp(t - 3 * myDuration, myEntryTime));
+    case VARIO_SCENARIO_STATIC:
+    default:
+      return 0.0;
+  }
+}
+
+double VarioScenario::nextGaussian(void) {
+  // xorshift32, gaussian distributed value by Box-Muller
+  double u[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    myRandom ^= myRandom << 13;
+    myRandom ^= myRandom >> 17;
+    myRandom ^= myRandom << 5;
+    u[i] = (myRandom + 1.0) / 4294967296.0;
+  }
+  return sqrt(-2.0 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+void VarioScenario::run(unsigned long aTime) {
+  const double dt = SCENARIO_STEP / 1000.0;
+  while (myTime + SCENARIO_STEP <= aTime) {
+    myTime += SCENARIO_STEP;
+    // vertical gusts as first order Gauss-Markov process
+    if (myTurbulenceSigma > 0) {
+      myGust += -myGust * dt / myTurbulenceTime
+                + myTurbulenceSigma * sqrt(2.0 * dt / myTurbulenceTime) * nextGaussian();
+    }
+    myVerticalSpeed = calcProfileSpeed(myTime / 1000.0) + myGust;
+    myAltitude += myVerticalSpeed * dt;
+    if (myScenario == VARIO_SCENARIO_TAKEOFF_LANDING && myAltitude < myStartAltitude) {
+      // on ground
+      myAltitude = myStartAltitude;
+      myVerticalSpeed = 0.0;
+      myGust = 0.0;
+    }
+  }
+}
+
+double VarioScenario::getAltitude(void) {
+  return myAltitude;
+}
+
+double VarioScenario::getVerticalSpeed(void) {
+  return myVerticalSpeed;
+}
+
+double VarioScenario::getPressure(void) {
+  // inverse of VarioMS5611::calcAltitude() with a drifting sea level pressure
+  double seaLevelPressure = PRESSURE_SEALEVEL + myWeatherDrift * myTime / 3600000.0;
+  return seaLevelPressure * pow(1.0 - myAltitude / 44330.0, 1.0 / 0.1902949);
+}
+
+double VarioScenario::getTemperature(void) {
+  // standard lapse rate of 0.65°C/100m
+  return myStartTemperature - 0.0065 * (myAltitude - myStartAltitude)
+         + myTemperatureAmplitude * sin(2 * M_PI * myTime / 1000.0 / myTemperaturePeriod);
+}
+
+void VarioScenario::calcRawValues(const uint16_t* aCalibration, double aPressure, double aTemperature,
+                                  uint32_t& aRawPressure, uint32_t& aRawTemperature) {
+  // TEMP = 2000 + dT * C6 / 2^23
+  double dT = (aTemperature * 100 - 2000) * 8388608.0 / aCalibration[5];
+  aRawTemperature = lround(aCalibration[4] * 256.0 + dT);
+  dT = (double) aRawTemperature - aCalibration[4] * 256.0;
+
+  // P = (D1 * SENS / 2^21 - OFF) / 2^15
+  double off = aCalibration[1] * 65536.0 + aCalibration[3] * dT / 128;
+  double sens = aCalibration[0] * 32768.0 + aCalibration[2] * dT / 256;
+  aRawPressure = lround((aPressure * 32768 + off) * 2097152.0 / sens);
+}
@@ -0,0 +1,149 @@
+/*
+VarioScenario.h - Declaration file for the flight scenarios of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file VarioScenario.h
+ *
+ * \brief header file of the flight scenarios, generating true altitude, pressure and temperature
+ *        traces for a simulated MS5611
+ *
+ * \author Author: Rainer Stransky
+ *
+ * \copyright This project is released under the GNU Public License v3
+ *          see https://www.gnu.org/licenses/gpl.html.
+ * Contact: opensource@so-fa.de
+ *
+ */
+
+#ifndef VARIO_SCENARIO_h
+#define VARIO_SCENARIO_h
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+/// version of the generated traces
+/** has to be incremented with each change of the generated traces, so results based on
+ * the scenarios refer to a defined set of input data
+ */
+#define VARIO_SCENARIO_VERSION    1
+
+/**
+ * flight profiles of the VarioScenario
+ */
+typedef enum
+{
+    VARIO_SCENARIO_STATIC,          ///< constant altitude (sensor on the desk)
+    VARIO_SCENARIO_THERMAL,         ///< 10s straight flight, thermal entry, climb, thermal exit
+    VARIO_SCENARIO_SINK,            ///< steady sink
+    VARIO_SCENARIO_TAKEOFF_LANDING  ///< 10s on ground, climb, cruise, descent, landing
+} vario_scenario_t;
+
+/// VarioScenario generates the true altitude, pressure and temperature of a parameterized flight
+/**
+ * The flight profile is combined with optional turbulence (vertical gusts), a drift of the
+ * weather (sea level pressure) and a temperature swing. All traces are deterministic for a
+ * given parameter set and seed, so latency, noise and detection results of different filter
+ * setups can be compared on the same input.
+ * calcRawValues() converts the true values to the raw D1/D2 values of a MS5611 with the given
+ * calibration values, to be fed into VarioMS5611::processRawSample().
+ */
+class VarioScenario
+{
+    public:
+	VarioScenario();
+
+	/// start the scenario
+	/**
+	 * the parameters set by the setXXX() methods are kept
+	 * @param aScenario flight profile
+	 * @param aStartAltitude altitude in m at the start of the scenario
+	 * @param aTemperature temperature in °C at the start of the scenario
+	 * @param aSeed seed of the pseudo random generator used for the turbulence
+	 */
+	void begin(vario_scenario_t aScenario, double aStartAltitude = 0.0, double aTemperature = 20.0, uint32_t aSeed = 1);
+
+	/// set the climb rate in m/s (thermal strength, sink rate, climb and descent rate)
+	void setClimbRate(double aRate);
+
+	/// set the time in s to enter and leave the thermal or climb
+	void setEntryTime(double aTime);
+
+	/// set the duration in s of the thermal, or each phase of the takeoff/landing scenario
+	void setDuration(double aTime);
+
+	/// set the turbulence, as standard deviation of the vertical gusts in m/s with the given correlation time in s
+	void setTurbulence(double aSigma, double aCorrelationTime = 1.0);
+
+	/// set the drift of the sea level pressure in Pa/h
+	void setWeatherDrift(double aDrift);
+
+	/// set a sinusoidal temperature swing with the given amplitude in °C and period in s
+	void setTemperatureSwing(double aAmplitude, double aPeriod);
+
+	/// advance the scenario to the given time in ms since begin()
+	void run(unsigned long aTime);
+
+	/// get the true altitude in m
+	double getAltitude(void);
+
+	/// get the true vertical speed in m/s
+	double getVerticalSpeed(void);
+
+	/// get the true pressure in Pa
+	double getPressure(void);
+
+	/// get the true temperature in °C
+	double getTemperature(void);
+
+	/// calculate the raw values of a MS5611 for the given pressure and temperature
+	/**
+	 * inverse of the first order compensation of the MS5611 datasheet
+	 * @param aCalibration calibration values C1-C6 (see VarioMS5611::getCalibrationValues())
+	 * @param aPressure pressure in Pa
+	 * @param aTemperature temperature in °C
+	 */
+	static void calcRawValues(const uint16_t* aCalibration, double aPressure, double aTemperature,
+	                          uint32_t& aRawPressure, uint32_t& aRawTemperature);
+
+    private:
+	vario_scenario_t myScenario;
+	double myClimbRate;
+	double myEntryTime;
+	double myDuration;
+	double myTurbulenceSigma;
+	double myTurbulenceTime;
+	double myWeatherDrift;
+	double myTemperatureAmplitude;
+	double myTemperaturePeriod;
+	double myStartAltitude;
+	double myStartTemperature;
+	double myAltitude;
+	double myVerticalSpeed;
+	double myGust;
+	unsigned long myTime;
+	uint32_t myRandom;
+
+	double calcProfileSpeed(double aTime);
+	double nextGaussian(void);
+};
+
+#endif
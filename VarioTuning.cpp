@@ -0,0 +1,194 @@
+/*
+VarioTuning.cpp - Class definition file for the runtime tuning channel of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "VarioTuning.h"
+
+VarioTuning::VarioTuning(VarioMS5611& aVario, Stream& aCommands, Print& aTelemetry) :
+  myVario(aVario), myCommands(aCommands), myTelemetry(aTelemetry) {
+}
+
+void VarioTuning::begin(void) {
+  myFramePos = 0;
+  myPending = false;
+  myLastRunCnt = myVario.getRunCount();
+  myCommandCnt = 0;
+  myRejectedFrames = 0;
+}
+
+uint16_t VarioTuning::getCommandCount(void) {
+  return myCommandCnt;
+}
+
+uint16_t VarioTuning::getRejectedFrames(void) {
+  return myRejectedFrames;
+}
+
+void VarioTuning::run() {
+  // a pending command blocks the receiver, the remaining bytes stay in the stream buffer
+  while (!myPending && myCommands.available() > 0) {
+    receive(myCommands.read());
+  }
+
+  unsigned int runCnt = myVario.getRunCount();
+  if (runCnt == myLastRunCnt) {
+    return;
+  }
+  // a new value has been read and processed, no sample is in progress
+  myLastRunCnt = runCnt;
+  if (myPending) {
+    report(myPendingParam, apply(myPendingParam, myPendingValue));
+    myPending = false;
+  }
+}
+
+void VarioTuning::receive(uint8_t aByte) {
+  if (myFramePos == 0 && aByte != VARIO_TUNING_SYNC) {
+    // out of sync, skip till the next frame start
+    return;
+  }
+  myFrame[myFramePos++] = aByte;
+  if (myFramePos < VARIO_TUNING_FRAME_SIZE) {
+    return;
+  }
+  myFramePos = 0;
+
+  uint8_t checksum = 0;
+  for (uint8_t i = 1; i < VARIO_TUNING_FRAME_SIZE - 1; i++) {
+    checksum ^= myFrame[i];
+  }
+  if (checksum != myFrame[VARIO_TUNING_FRAME_SIZE - 1]) {
+    myRejectedFrames++;
+    return;
+  }
+
+  uint32_t raw = (uint32_t) myFrame[2] | (uint32_t) myFrame[3] << 8
+               | (uint32_t) myFrame[4] << 16 | (uint32_t) myFrame[5] << 24;
+  memcpy(&myPendingValue, &raw, sizeof(myPendingValue));
+  myPendingParam = myFrame[1];
+  myPending = true;
+}
+
+// valid range of a smoothing factor, 1.0 would freeze the value
+static bool isSmoothingFactor(float aValue) {
+  return aValue >= 0.0f && aValue < 1.0f;
+}
+
+vario_tuning_status_t VarioTuning::apply(uint8_t aParam, float aValue) {
+  // NaN passes each range check below, and infinity can't be converted to int
+  if (!isfinite(aValue)) {
+    return VARIO_TUNING_INVALID_VALUE;
+  }
+  switch (aParam) {
+    case VARIO_TUNE_OVERSAMPLING:
+      // out of the int range, the conversion is undefined
+      if (aValue < 256.0f || aValue > 4096.0f) {
+        return VARIO_TUNING_INVALID_VALUE;
+      }
+      switch ((int) aValue) {
+        case 256:  myVario.setOversampling(MS5611_ULTRA_LOW_POWER); break;
+        case 512:  myVario.setOversampling(MS5611_LOW_POWER); break;
+        case 1024: myVario.setOversampling(MS5611_STANDARD); break;
+        case 2048: myVario.setOversampling(MS5611_HIGH_RES); break;
+        case 4096: myVario.setOversampling(MS5611_ULTRA_HIGH_RES); break;
+        default:   return VARIO_TUNING_INVALID_VALUE;
+      }
+      break;
+    case VARIO_TUNE_PRESSURE_SMOOTHING:
+      if (!isSmoothingFactor(aValue)) {
+        return VARIO_TUNING_INVALID_VALUE;
+      }
+      myVario.setPressureSmoothingFactor(aValue);
+      break;
+    case VARIO_TUNE_VERTICAL_SPEED_SMOOTHING:
+      if (!isSmoothingFactor(aValue)) {
+        return VARIO_TUNING_INVALID_VALUE;
+      }
+      myVario.setVerticalSpeedSmoothingFactor(aValue);
+      break;
+    case VARIO_TUNE_VERTICAL_ACCELERATION_SMOOTHING:
+      if (!isSmoothingFactor(aValue)) {
+        return VARIO_TUNING_INVALID_VALUE;
+      }
+      myVario.setVerticalAccelerationSmoothingFactor(aValue);
+      break;
+    case VARIO_TUNE_SECOND_ORDER_COMPENSATION:
+      myVario.setSecondOrderCompenstation(aValue != 0.0f);
+      break;
+    case VARIO_TUNE_MAX_DUTY_CYCLE:
+      if (aValue < 0.1f || aValue > 1.0f) {
+        return VARIO_TUNING_INVALID_VALUE;
+      }
+      myVario.setMaxDutyCycle(aValue);
+      break;
+    case VARIO_TUNE_ADAPTIVE_SMOOTHING:
+      // keep the bounds of the smoothing factor, only switch it on or off
+      myVario.setAdaptivePressureSmoothing(aValue != 0.0f, myVario.getAdaptivePressureSmoothingMinFactor(),
+                                           myVario.getAdaptivePressureSmoothingMaxFactor());
+      break;
+    default:
+      return VARIO_TUNING_UNKNOWN_PARAM;
+  }
+  myCommandCnt++;
+  return VARIO_TUNING_OK;
+}
+
+float VarioTuning::readBack(uint8_t aParam) {
+  switch (aParam) {
+    case VARIO_TUNE_OVERSAMPLING:
+      // ms5611_osr_t is 2 * log2(samples / 256)
+      return 256 << (myVario.getOversampling() / 2);
+    case VARIO_TUNE_PRESSURE_SMOOTHING:
+      return myVario.getPressureSmoothingFactor();
+    case VARIO_TUNE_VERTICAL_SPEED_SMOOTHING:
+      return myVario.getVerticalSpeedSmoothingFactor();
+    case VARIO_TUNE_VERTICAL_ACCELERATION_SMOOTHING:
+      return myVario.getVerticalAccelerationSmoothingFactor();
+    case VARIO_TUNE_SECOND_ORDER_COMPENSATION:
+      return myVario.getSecondOrderCompenstation() ? 1.0f : 0.0f;
+    case VARIO_TUNE_MAX_DUTY_CYCLE:
+      return myVario.getMaxDutyCycle();
+    case VARIO_TUNE_ADAPTIVE_SMOOTHING:
+      return myVario.getAdaptivePressureSmoothing() ? 1.0f : 0.0f;
+    default:
+      return 0.0f;
+  }
+}
+
+void VarioTuning::report(uint8_t aParam, vario_tuning_status_t aStatus) {
+  myTelemetry.print("# tuning param: ");
+  myTelemetry.print(aParam);
+  myTelemetry.print(" value: ");
+  myTelemetry.print(readBack(aParam), 4);
+  myTelemetry.print(" status: ");
+  myTelemetry.print(aStatus);
+  myTelemetry.print(" run: ");
+  myTelemetry.print(myLastRunCnt);
+  myTelemetry.print(" time: ");
+  myTelemetry.print(millis());
+  myTelemetry.println();
+}
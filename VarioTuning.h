@@ -0,0 +1,137 @@
+/*
+VarioTuning.h - Declaration file for the runtime tuning channel of the VarioMS5611 Barometric Variometer Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file VarioTuning.h
+ *
+ * \brief header file of the runtime tuning channel, setting the parameters of a VarioMS5611
+ *        instance by compact binary commands, without restart
+ *
+ * \author Author: Rainer Stransky
+ *
+ * \copyright This project is released under the GNU Public License v3
+ *          see https://www.gnu.org/licenses/gpl.html.
+ * Contact: opensource@so-fa.de
+ *
+ */
+
+#ifndef VARIO_TUNING_h
+#define VARIO_TUNING_h
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "VarioMS5611.h"
+
+/// first byte of a tuning command frame
+#define VARIO_TUNING_SYNC         0xA5
+
+/// size in bytes of a tuning command frame
+/**
+ * frame layout:
+ * * byte 0 : VARIO_TUNING_SYNC
+ * * byte 1 : parameter id (see vario_tuning_param_t)
+ * * byte 2 : float value, 4 bytes little endian (IEEE 754 single precision)
+ * * byte 6 : checksum, XOR of the bytes 1-5
+ */
+#define VARIO_TUNING_FRAME_SIZE   7
+
+/**
+ * parameters which can be set by the tuning channel
+ */
+typedef enum
+{
+    VARIO_TUNE_OVERSAMPLING = 1,                  ///< oversampling rate as number of samples (256, 512, 1024, 2048, 4096)
+    VARIO_TUNE_PRESSURE_SMOOTHING,                ///< IIR smoothing factor of the pressure value (0.0 - 1.0)
+    VARIO_TUNE_VERTICAL_SPEED_SMOOTHING,          ///< IIR smoothing factor of the vertical speed value (0.0 - 1.0)
+    VARIO_TUNE_VERTICAL_ACCELERATION_SMOOTHING,   ///< IIR smoothing factor of the vertical acceleration value (0.0 - 1.0)
+    VARIO_TUNE_SECOND_ORDER_COMPENSATION,         ///< second order temperature compensation (0 = off, 1 = on)
+    VARIO_TUNE_MAX_DUTY_CYCLE,                    ///< maximal conversion duty cycle (0.1 - 1.0)
+    VARIO_TUNE_ADAPTIVE_SMOOTHING                 ///< innovation adaptive pressure smoothing (0 = off, 1 = on)
+} vario_tuning_param_t;
+
+/**
+ * result of a tuning command, reported in the telemetry stream
+ */
+typedef enum
+{
+    VARIO_TUNING_OK,                ///< the parameter has been set
+    VARIO_TUNING_UNKNOWN_PARAM,     ///< the parameter id is not known
+    VARIO_TUNING_INVALID_VALUE      ///< the value is out of the range of the parameter, nothing changed
+} vario_tuning_status_t;
+
+/// VarioTuning sets the parameters of a VarioMS5611 at runtime, by commands received from a Stream
+/**
+ * The commands are compact binary frames (see VARIO_TUNING_FRAME_SIZE), e.g. sent via the
+ * Serial monitor or a radio link. Frames with a wrong checksum are dropped, the receiver
+ * resynchronizes on the next VARIO_TUNING_SYNC byte.
+ * A received command is kept pending, till VarioMS5611::run() has read a new value. It is applied
+ * right after this read, so that each sample is processed completely with either the old or the
+ * new parameter. Each command is reported by a comment line in the telemetry stream:
+ *
+ *     # tuning param: <id> value: <value> status: <status> run: <run count> time: <ms>
+ *
+ * where value is the parameter value read back after the change, so that logged flight data
+ * can be related to the parameter set in use.
+ */
+class VarioTuning
+{
+    public:
+	VarioTuning(VarioMS5611& aVario, Stream& aCommands, Print& aTelemetry);
+
+	/// for initialzation
+	/** has to be called once, after VarioMS5611::begin() */
+	void begin(void);
+
+	/// non blocking command handling, has to be called in the loop next to VarioMS5611::run()
+	/**
+	 * - reads the available bytes of the command stream
+	 * - applies a pending command, if a new value has been read by VarioMS5611::run()
+	 */
+	void run();
+
+	/// get the number of commands applied since begin()
+	uint16_t getCommandCount(void);
+
+	/// get the number of frames dropped because of a wrong checksum since begin()
+	uint16_t getRejectedFrames(void);
+
+    private:
+	VarioMS5611& myVario;
+	Stream& myCommands;
+	Print& myTelemetry;
+	uint8_t myFrame[VARIO_TUNING_FRAME_SIZE];
+	uint8_t myFramePos;
+	bool myPending;
+	uint8_t myPendingParam;
+	float myPendingValue;
+	unsigned int myLastRunCnt;
+	uint16_t myCommandCnt;
+	uint16_t myRejectedFrames;
+
+	void receive(uint8_t aByte);
+	vario_tuning_status_t apply(uint8_t aParam, float aValue);
+	float readBack(uint8_t aParam);
+	void report(uint8_t aParam, vario_tuning_status_t aStatus);
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+BarographVerify.cpp - Host tool to verify barograph logs written by the VarioBarograph logger of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// build: g++ -O2 -o BarographVerify BarographVerify.cpp
+// usage: BarographVerify <logfile> <interval ms> [tolerance ms]
+//
+// checks the record continuity (sequence numbers) and the timing (interval) of a
+// barograph log, see VarioBarograph.h for the record layout
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define RECORD_SIZE 16
+
+static uint32_t getLE(const uint8_t* aBuf, int aBytes) {
+  uint32_t value = 0;
+  for (int i = aBytes-1; i >= 0; i--) {
+    value = (value << 8) | aBuf[i];
+  }
+  return value;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <logfile> <interval ms> [tolerance ms]\n", argv[0]);
+    return 2;
+  }
+  FILE* file = fopen(argv[1], "rb");
+  if (file == NULL) {
+    perror(argv[1]);
+    return 2;
+  }
+  long interval = atol(argv[2]);
+  long tolerance = argc > 3 ? atol(argv[3]) : interval / 10;
+
+  uint8_t rec[RECORD_SIZE];
+  unsigned long records = 0;
+  unsigned long gaps = 0;
+  unsigned long lostRecords = 0;
+  unsigned long timingErrors = 0;
+  long maxDeviation = 0;
+  uint16_t lastSeq = 0;
+  uint32_t lastTime = 0;
+  size_t len;
+
+  while ((len = fread(rec, 1, RECORD_SIZE, file)) == RECORD_SIZE) {
+    uint16_t seq = getLE(rec, 2);
+    uint32_t time = getLE(rec + 4, 4);
+    int32_t pressure = getLE(rec + 8, 4);
+    int32_t altitude = getLE(rec + 12, 4);
+
+    if (records > 0) {
+      uint16_t seqDelta = seq - lastSeq;
+      long expected = interval * seqDelta;
+      long deviation = labs((long)(time - lastTime) - expected);
+      if (seqDelta != 1) {
+        gaps++;
+        lostRecords += (uint16_t)(seqDelta - 1);
+        printf("gap: record %lu, sequence %u -> %u (%u records lost)\n",
+            records, lastSeq, seq, (uint16_t)(seqDelta - 1));
+      }
+      if (deviation > maxDeviation) {
+        maxDeviation = deviation;
+      }
+      if (deviation > tolerance) {
+        timingErrors++;
+        printf("timing: record %lu, sequence %u, dt=%ld ms, expected %ld ms\n",
+            records, seq, (long)(time - lastTime), expected);
+      }
+    }
+    if (pressure <= 0 || altitude < -100000 || altitude > 2000000) {
+      printf("value: record %lu, sequence %u, implausible pressure %ld Pa / altitude %ld cm\n",
+          records, seq, (long)pressure, (long)altitude);
+    }
+    lastSeq = seq;
+    lastTime = time;
+    records++;
+  }
+  fclose(file);
+
+  printf("records: %lu, gaps: %lu, lost records: %lu, timing errors: %lu, max. deviation: %ld ms\n",
+      records, gaps, lostRecords, timingErrors, maxDeviation);
+  if (len != 0) {
+    printf("truncated record at end of file (%u bytes)\n", (unsigned) len);
+    return 1;
+  }
+  return (gaps == 0 && timingErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/*
+CompensationTest.cpp - Host test of the temperature compensation of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// build: g++ -O2 -DARDUINO=100 -Ihost -I.. -o CompensationTest CompensationTest.cpp host/host.cpp
+//            ../VarioMS5611.cpp ../VarioFilter.cpp ../VarioScenario.cpp
+// usage: CompensationTest
+//
+// checks the integer calculation of the temperature and the compensated pressure, with and
+// without second order temperature compensation:
+// * golden vectors at 20°C, 10°C and -20°C, and VarioMS5611::selfTest()
+// * sweeps of D1/D2 over -40°C..85°C and 10..1200 mbar for several calibration sets,
+//   compared with a double precision implementation of the datasheet formulas
+// * steps of D2 and D1 across the whole range and the 20°C / -15°C branches, which must not
+//   cause jumps of the results
+// * for each calculation, the values of run() (getXXX()) against the values of readXXX()
+// returns 0 if all checks passed
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "VarioMS5611.h"
+#include "VarioScenario.h"
+
+// tolerances of the integer calculation against the double precision reference
+#define TEMP_TOLERANCE      2     // 1/100 °C
+#define PRESSURE_TOLERANCE  3     // Pa
+
+static const uint16_t calibrations[][6] = {
+  { 40127, 36924, 23317, 23282, 33464, 28312 },   // datasheet example
+  { 53422, 55328, 33651, 30872, 32438, 28543 },
+  { 32768, 29430, 17432, 17991, 36452, 26870 }
+};
+
+static unsigned long checks = 0;
+static unsigned long failures = 0;
+
+static void check(bool aOk, const char* aWhat, uint32_t aD1, uint32_t aD2, int aCompensation, double aValue, double aExpected) {
+  checks++;
+  if (!aOk) {
+    failures++;
+    if (failures <= 20) {
+      printf("FAIL %s: D1=%u D2=%u compensation=%d value=%.2f expected=%.2f\n",
+             aWhat, aD1, aD2, aCompensation, aValue, aExpected);
+    }
+  }
+}
+
+// datasheet formulas in double precision, only TEMP is truncated to an integer as in the datasheet,
+// because the second order terms depend on its square (up to 6 Pa at -40°C)
+static void calcReference(const uint16_t* aC, uint32_t aD1, uint32_t aD2, bool aCompensation,
+                          double& aTemp, double& aPressure) {
+  double dT = aD2 - aC[4] * 256.0;
+  double temp = 2000 + trunc(dT * aC[5] / 8388608.0);
+  double off = aC[1] * 65536.0 + aC[3] * dT / 128.0;
+  double sens = aC[0] * 32768.0 + aC[2] * dT / 256.0;
+  double t2 = 0, off2 = 0, sens2 = 0;
+  if (aCompensation && temp < 2000) {
+    t2 = dT * dT / 2147483648.0;
+    off2 = 5 * (temp - 2000) * (temp - 2000) / 2;
+    sens2 = 5 * (temp - 2000) * (temp - 2000) / 4;
+    if (temp < -1500) {
+      off2 += 7 * (temp + 1500) * (temp + 1500);
+      sens2 += 11 * (temp + 1500) * (temp + 1500) / 2;
+    }
+  }
+  aTemp = temp - t2;
+  aPressure = (aD1 * (sens - sens2) / 2097152.0 - (off - off2)) / 32768.0;
+}
+
+// calculation of the library, the raw values are processed like a sample of run(),
+// the values of the run path (getXXX()) have to match the values of the read path (readXXX())
+static void calcLibrary(VarioMS5611& aVario, uint32_t aD1, uint32_t aD2, bool aCompensation,
+                        int32_t& aTemp, int32_t& aPressure) {
+  static unsigned long time = 0;
+  aVario.setSecondOrderCompenstation(aCompensation);
+  aVario.processRawSample(aD1, aD2, time += 20);
+  double temp = aVario.readTemperature(aCompensation);
+  aPressure = aVario.readPressure(aCompensation);
+  check(aVario.getTemperature() == temp, "run/read TEMP", aD1, aD2, aCompensation, aVario.getTemperature(), temp);
+  check(aVario.getPressure() == aPressure, "run/read P", aD1, aD2, aCompensation, aVario.getPressure(), aPressure);
+  aTemp = lround(temp * 100);
+}
+
+static void testGoldenVectors(void) {
+  static const struct {
+    uint32_t d1, d2;
+    int32_t temp[2], pressure[2];
+  } vectors[] = {
+    { 9085466, 8569150, {  2007,  2007 }, { 100009, 100009 } },
+    { 9085466, 8270494, {  1001,   961 }, {  98070,  97981 } },
+    { 9085466, 7381624, { -1999, -2653 }, {  92300,  90749 } }
+  };
+  VarioMS5611 vario;
+  vario.begin(calibrations[0]);
+  check(vario.selfTest(), "selfTest", 0, 0, 0, 0, 1);
+  for (unsigned i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    for (int compensation = 0; compensation < 2; compensation++) {
+      int32_t temp, pressure;
+      double refTemp, refPressure;
+      calcLibrary(vario, vectors[i].d1, vectors[i].d2, compensation, temp, pressure);
+      check(temp == vectors[i].temp[compensation], "golden TEMP", vectors[i].d1, vectors[i].d2, compensation,
+            temp, vectors[i].temp[compensation]);
+      check(pressure == vectors[i].pressure[compensation], "golden P", vectors[i].d1, vectors[i].d2, compensation,
+            pressure, vectors[i].pressure[compensation]);
+      // the golden values themselves have to match the reference
+      calcReference(calibrations[0], vectors[i].d1, vectors[i].d2, compensation, refTemp, refPressure);
+      check(fabs(vectors[i].temp[compensation] - refTemp) <= TEMP_TOLERANCE, "golden TEMP reference",
+            vectors[i].d1, vectors[i].d2, compensation, vectors[i].temp[compensation], refTemp);
+      check(fabs(vectors[i].pressure[compensation] - refPressure) <= PRESSURE_TOLERANCE, "golden P reference",
+            vectors[i].d1, vectors[i].d2, compensation, vectors[i].pressure[compensation], refPressure);
+    }
+  }
+}
+
+static void testSweep(const uint16_t* aC) {
+  VarioMS5611 vario;
+  vario.begin(aC);
+  for (int temperature = -4000; temperature <= 8500; temperature += 25) {
+    for (int pressure = 1000; pressure <= 120000; pressure += 500) {
+      uint32_t d1, d2;
+      VarioScenario::calcRawValues(aC, pressure, temperature / 100.0, d1, d2);
+      for (int compensation = 0; compensation < 2; compensation++) {
+        int32_t temp, p;
+        double refTemp, refPressure;
+        calcLibrary(vario, d1, d2, compensation, temp, p);
+        calcReference(aC, d1, d2, compensation, refTemp, refPressure);
+        check(fabs(temp - refTemp) <= TEMP_TOLERANCE, "sweep TEMP", d1, d2, compensation, temp, refTemp);
+        check(fabs(p - refPressure) <= PRESSURE_TOLERANCE, "sweep P", d1, d2, compensation, p, refPressure);
+      }
+    }
+  }
+}
+
+static void testSteps(const uint16_t* aC) {
+  VarioMS5611 vario;
+  vario.begin(aC);
+  // D2 range of -40°C..85°C at 1000 mbar, small steps around the branches at 20°C and -15°C
+  uint32_t d1, d2Min, d2Max, d2;
+  VarioScenario::calcRawValues(aC, 100000, -40, d1, d2Min);
+  VarioScenario::calcRawValues(aC, 100000, 85, d1, d2Max);
+  // a step of the integer TEMP changes P by up to 4 Pa at -40°C, so the pressure steps
+  // are compared with the steps of the reference
+  for (int compensation = 0; compensation < 2; compensation++) {
+    int32_t lastTemp = 0, lastPressure = 0;
+    double lastRefPressure = 0;
+    for (d2 = d2Min; d2 <= d2Max; d2 += 7) {
+      int32_t temp, pressure;
+      double refTemp, refPressure;
+      calcLibrary(vario, d1, d2, compensation, temp, pressure);
+      calcReference(aC, d1, d2, compensation, refTemp, refPressure);
+      if (d2 != d2Min) {
+        check(temp >= lastTemp && temp - lastTemp <= TEMP_TOLERANCE, "D2 step TEMP", d1, d2, compensation, temp, lastTemp);
+        check(fabs((pressure - lastPressure) - (refPressure - lastRefPressure)) <= PRESSURE_TOLERANCE, "D2 step P",
+              d1, d2, compensation, pressure - lastPressure, refPressure - lastRefPressure);
+      }
+      lastTemp = temp;
+      lastPressure = pressure;
+      lastRefPressure = refPressure;
+    }
+  }
+  // pressure has to increase monotonic with D1, at the lowest temperature
+  for (int compensation = 0; compensation < 2; compensation++) {
+    int32_t lastPressure = 0;
+    uint32_t d1Min, d1Max;
+    VarioScenario::calcRawValues(aC, 1000, -40, d1Min, d2);
+    VarioScenario::calcRawValues(aC, 120000, -40, d1Max, d2);
+    for (d1 = d1Min; d1 <= d1Max; d1 += 101) {
+      int32_t temp, pressure;
+      calcLibrary(vario, d1, d2, compensation, temp, pressure);
+      if (d1 != d1Min) {
+        check(pressure >= lastPressure && pressure - lastPressure <= PRESSURE_TOLERANCE, "D1 step P",
+              d1, d2, compensation, pressure, lastPressure);
+      }
+      lastPressure = pressure;
+    }
+  }
+}
+
+int main(void) {
+  testGoldenVectors();
+  for (unsigned i = 0; i < sizeof(calibrations) / sizeof(calibrations[0]); i++) {
+    testSweep(calibrations[i]);
+    testSteps(calibrations[i]);
+  }
+  printf("checks: %lu, failures: %lu\n", checks, failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+FleetBench.cpp - Host benchmark of many VarioMS5611 instances fed with simulated samples.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// build: g++ -O2 -DARDUINO=100 -Ihost -I.. -o FleetBench FleetBench.cpp host/host.cpp
+//            ../VarioMS5611.cpp ../VarioFilter.cpp ../VarioScenario.cpp
+// usage: FleetBench [max. number of sensors] [max. number of readers] [samples per sensor]
+//
+// runs 1, 2, 4, ... sensors (VarioMS5611 instances, each with its own thermal scenario)
+// in one loop, every sensor processes one sample per tick (VarioMS5611::processRawSample()).
+// After each tick 1, 2, 4, ... readers read the pressure, smoothed pressure, vertical speed
+// and acceleration of every sensor. Prints per fleet size and number of readers:
+// * CPU time (CLOCK_PROCESS_CPUTIME_ID) in µs per processed sample, including the reads
+// * mean and maximal wall time in µs of one tick (latency till the last reader got the
+//   values of the last sensor)
+// The raw values of the scenarios are calculated before the measurement.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "VarioMS5611.h"
+#include "VarioScenario.h"
+
+#define SAMPLE_INTERVAL   22    // ms between two samples of a sensor (OSR 4096)
+
+static const uint16_t calibration[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+
+static double cpuTime(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+int main(int argc, char* argv[]) {
+  unsigned maxSensors = argc > 1 ? atoi(argv[1]) : 256;
+  unsigned maxReaders = argc > 2 ? atoi(argv[2]) : 8;
+  unsigned samples = argc > 3 ? atoi(argv[3]) : 2000;
+  if (maxSensors == 0 || maxReaders == 0 || samples == 0) {
+    fprintf(stderr, "usage: %s [max. number of sensors] [max. number of readers] [samples per sensor]\n", argv[0]);
+    return 2;
+  }
+
+  // raw values of all sensors, different seeds and climb rates
+  uint32_t* d1 = new uint32_t[maxSensors * samples];
+  uint32_t* d2 = new uint32_t[maxSensors * samples];
+  for (unsigned s = 0; s < maxSensors; s++) {
+    VarioScenario flight;
+    flight.setClimbRate(0.5 + (s % 8) * 0.5);
+    flight.setTurbulence(0.3);
+    flight.begin(VARIO_SCENARIO_THERMAL, 500.0 + s, 20.0, s + 1);
+    for (unsigned i = 0; i < samples; i++) {
+      flight.run(i * SAMPLE_INTERVAL);
+      VarioScenario::calcRawValues(calibration, flight.getPressure(), flight.getTemperature(),
+                                   d1[s * samples + i], d2[s * samples + i]);
+    }
+  }
+
+  printf("# sensors  readers  cpu.us/sample  tick.mean[us]  tick.max[us]\n");
+  for (unsigned n = 1; n <= maxSensors; n *= 2) {
+    for (unsigned readers = 1; readers <= maxReaders; readers *= 2) {
+      VarioMS5611* fleet = new VarioMS5611[n];
+      for (unsigned s = 0; s < n; s++) {
+        fleet[s].begin(calibration);
+      }
+      double cpuStart = cpuTime();
+      unsigned long start = micros();
+      unsigned long maxTick = 0;
+      double checksum = 0;
+      for (unsigned i = 0; i < samples; i++) {
+        unsigned long tickStart = micros();
+        for (unsigned s = 0; s < n; s++) {
+          fleet[s].processRawSample(d1[s * samples + i], d2[s * samples + i], i * SAMPLE_INTERVAL);
+        }
+        for (unsigned r = 0; r < readers; r++) {
+          for (unsigned s = 0; s < n; s++) {
+            checksum += fleet[s].getPressure() + fleet[s].getSmoothedPressure()
+                        + fleet[s].getVerticalSpeed() + fleet[s].getVerticalAcceleration();
+          }
+        }
+        unsigned long tick = micros() - tickStart;
+        if (tick > maxTick) {
+          maxTick = tick;
+        }
+      }
+      double cpu = cpuTime() - cpuStart;
+      double elapsed = micros() - start;
+      // the checksum keeps the compiler from dropping the getters
+      printf("%9u  %7u  %13.3f  %13.1f  %12lu  # %.0f\n", n, readers, cpu / ((double) n * samples),
+             elapsed / samples, maxTick, checksum);
+      delete[] fleet;
+    }
+  }
+  delete[] d1;
+  delete[] d2;
+  return 0;
+}
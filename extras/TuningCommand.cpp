@@ -0,0 +1,55 @@
+/*
+TuningCommand.cpp - Host tool to create tuning commands for the VarioTuning channel of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// build: g++ -O2 -o TuningCommand TuningCommand.cpp
+// usage: TuningCommand <param id> <value> [<param id> <value> ...] > /dev/ttyUSB0
+//
+// writes one command frame per parameter/value pair to stdout,
+// see VarioTuning.h for the frame layout and the parameter ids
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TUNING_SYNC 0xA5
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || argc % 2 == 0) {
+    fprintf(stderr, "usage: %s <param id> <value> [<param id> <value> ...]\n", argv[0]);
+    return 2;
+  }
+  for (int arg = 1; arg < argc; arg += 2) {
+    float value = (float) atof(argv[arg + 1]);
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+
+    uint8_t frame[7];
+    frame[0] = TUNING_SYNC;
+    frame[1] = (uint8_t) atoi(argv[arg]);
+    uint8_t checksum = frame[1];
+    for (int i = 0; i < 4; i++) {
+      frame[2 + i] = raw >> (8 * i);
+      checksum ^= frame[2 + i];
+    }
+    frame[6] = checksum;
+    fwrite(frame, 1, sizeof(frame), stdout);
+  }
+  return 0;
+}
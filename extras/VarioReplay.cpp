@@ -0,0 +1,206 @@
+/*
+VarioReplay.cpp - Host tool to run flight scenarios and black box dumps through the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// build: g++ -O2 -DARDUINO=100 -Ihost -I.. -o VarioReplay VarioReplay.cpp host/host.cpp
+//            ../VarioMS5611.cpp ../VarioFilter.cpp ../VarioScenario.cpp
+// usage: VarioReplay scenario <0-3> [climb rate m/s] [turbulence m/s] [sample interval ms]
+//        VarioReplay blackbox <dump file>
+//
+// feeds the raw samples of a simulated MS5611 (VarioScenario) or of a black box dump
+// (see VarioMS5611::dumpBlackBox()) into VarioMS5611::processRawSample() and prints
+// one line per sample: time in ms, pressure in Pa, smoothed pressure in Pa, vertical speed
+// in cm/s, vertical acceleration in cm/s² and for scenarios the true altitude in m, true
+// vertical speed in cm/s and true vertical acceleration in cm/s².
+// For scenarios the rms error and the lag (delay of the maximal cross correlation with the
+// true value) of the vertical speed and acceleration are reported at the end.
+// black box dumps are replayed without warm-up phase and with the filter settings of the dump
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "VarioMS5611.h"
+#include "VarioScenario.h"
+
+// datasheet calibration values, used for the scenarios
+static const uint16_t calibration[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+
+static uint32_t getLE(const uint8_t* aBuf, int aBytes) {
+  uint32_t value = 0;
+  for (int i = aBytes-1; i >= 0; i--) {
+    value = (value << 8) | aBuf[i];
+  }
+  return value;
+}
+
+static double calcRmsError(const double* aMeasured, const double* aTrue, unsigned long aCnt) {
+  double sumError2 = 0;
+  for (unsigned long i = 0; i < aCnt; i++) {
+    sumError2 += (aMeasured[i] - aTrue[i]) * (aMeasured[i] - aTrue[i]);
+  }
+  return sqrt(sumError2 / aCnt);
+}
+
+// number of samples the measured values are delayed against the true values
+static unsigned long calcLag(const double* aMeasured, const double* aTrue, unsigned long aCnt, unsigned long aMaxLag) {
+  double meanMeasured = 0, meanTrue = 0;
+  for (unsigned long i = 0; i < aCnt; i++) {
+    meanMeasured += aMeasured[i] / aCnt;
+    meanTrue += aTrue[i] / aCnt;
+  }
+  unsigned long lag = 0;
+  double maxCorrelation = -1e300;
+  for (unsigned long k = 0; k <= aMaxLag && k < aCnt / 2; k++) {
+    double correlation = 0;
+    for (unsigned long i = 0; i + k < aCnt; i++) {
+      correlation += (aMeasured[i + k] - meanMeasured) * (aTrue[i] - meanTrue);
+    }
+    correlation /= aCnt - k;
+    if (correlation > maxCorrelation) {
+      maxCorrelation = correlation;
+      lag = k;
+    }
+  }
+  return lag;
+}
+
+static int runScenario(int argc, char* argv[]) {
+  vario_scenario_t scenario = (vario_scenario_t) atoi(argv[2]);
+  double climbRate = argc > 3 ? atof(argv[3]) : 1.0;
+  double turbulence = argc > 4 ? atof(argv[4]) : 0.0;
+  unsigned long interval = argc > 5 ? atol(argv[5]) : 22;
+  if (scenario < VARIO_SCENARIO_STATIC || scenario > VARIO_SCENARIO_TAKEOFF_LANDING || interval == 0) {
+    fprintf(stderr, "invalid scenario or sample interval\n");
+    return 2;
+  }
+
+  VarioMS5611 vario;
+  vario.begin(calibration);
+  VarioScenario flight;
+  flight.setClimbRate(climbRate);
+  flight.setTurbulence(turbulence);
+  flight.begin(scenario, 500.0);
+
+  // 10s lead, 4 phases of 60s, the statistics start after the lead
+  const unsigned long duration = 250000;
+  const unsigned long lead = 10000;
+  unsigned long maxSamples = (duration - lead) / interval + 1;
+  double* speed = new double[maxSamples];
+  double* trueSpeed = new double[maxSamples];
+  double* accel = new double[maxSamples];
+  double* trueAccel = new double[maxSamples];
+  unsigned long samples = 0;
+  double lastTrueSpeed = 0;
+  for (unsigned long time = 0; time <= duration; time += interval) {
+    uint32_t d1, d2;
+    flight.run(time);
+    VarioScenario::calcRawValues(calibration, flight.getPressure(), flight.getTemperature(), d1, d2);
+    vario.processRawSample(d1, d2, time);
+    double flightSpeed = flight.getVerticalSpeed() * 100;
+    double flightAccel = (flightSpeed - lastTrueSpeed) * 1000.0 / interval;
+    lastTrueSpeed = flightSpeed;
+    if (time > lead && samples < maxSamples) {
+      speed[samples] = vario.getVerticalSpeed();
+      trueSpeed[samples] = flightSpeed;
+      accel[samples] = vario.getVerticalAcceleration();
+      trueAccel[samples] = flightAccel;
+      samples++;
+    }
+    printf("%lu %.0f %.1f %d %.1f %.2f %.0f %.1f\n", time, vario.getPressure(), vario.getSmoothedPressure(),
+           vario.getVerticalSpeed(), vario.getVerticalAcceleration(), flight.getAltitude(), flightSpeed, flightAccel);
+  }
+  unsigned long maxLag = 5000 / interval;
+  fprintf(stderr, "scenario version: %d, samples: %lu\n", VARIO_SCENARIO_VERSION, samples);
+  fprintf(stderr, "vertical speed rms error: %.1f cm/s, lag: %lu ms\n", calcRmsError(speed, trueSpeed, samples),
+          calcLag(speed, trueSpeed, samples, maxLag) * interval);
+  fprintf(stderr, "vertical acceleration rms error: %.1f cm/s^2, lag: %lu ms\n", calcRmsError(accel, trueAccel, samples),
+          calcLag(accel, trueAccel, samples, maxLag) * interval);
+  delete[] speed;
+  delete[] trueSpeed;
+  delete[] accel;
+  delete[] trueAccel;
+  return 0;
+}
+
+static int runBlackBox(char* argv[]) {
+  FILE* file = fopen(argv[2], "rb");
+  if (file == NULL) {
+    perror(argv[2]);
+    return 2;
+  }
+  uint8_t header[40];
+  if (fread(header, 1, 6, file) != 6 || header[0] != 'V' || header[1] != 'B' || header[2] != 'B') {
+    fprintf(stderr, "%s: no black box dump\n", argv[2]);
+    return 2;
+  }
+  if (header[3] != 2) {
+    fprintf(stderr, "%s: unknown format version %d\n", argv[2], header[3]);
+    return 2;
+  }
+  if (fread(header + 6, 1, sizeof(header) - 6, file) != sizeof(header) - 6) {
+    fprintf(stderr, "%s: incomplete header\n", argv[2]);
+    return 2;
+  }
+  uint16_t cnt = getLE(header + 4, 2);
+  uint16_t dumpCalibration[6];
+  for (int i = 0; i < 6; i++) {
+    dumpCalibration[i] = getLE(header + 6 + 2 * i, 2);
+  }
+  float settings[5];
+  for (int i = 0; i < 5; i++) {
+    uint32_t raw = getLE(header + 20 + 4 * i, 4);
+    memcpy(&settings[i], &raw, sizeof(raw));
+  }
+
+  VarioMS5611 vario;
+  vario.begin(dumpCalibration, false);
+  vario.setSecondOrderCompenstation(header[18] & 0x01);
+  vario.setPressureSmoothingFactor(settings[0]);
+  vario.setVerticalSpeedSmoothingFactor(settings[1]);
+  vario.setVerticalAccelerationSmoothingFactor(settings[2]);
+  vario.setAdaptivePressureSmoothing(header[18] & 0x02, settings[3], settings[4]);
+  // the window of the Savitzky-Golay mode is not part of the dump, the defaults are used
+  vario.setVerticalSpeedMode((vario_mode_t) header[19]);
+  fprintf(stderr, "compensation: %d, adaptive: %d, mode: %d, factors: %.3f %.3f %.3f %.3f %.3f\n",
+          header[18] & 0x01, (header[18] & 0x02) >> 1, header[19],
+          settings[0], settings[1], settings[2], settings[3], settings[4]);
+  uint8_t sample[10];
+  uint16_t samples = 0;
+  while (samples < cnt && fread(sample, 1, sizeof(sample), file) == sizeof(sample)) {
+    vario.processRawSample(getLE(sample + 4, 3), getLE(sample + 7, 3), getLE(sample, 4));
+    printf("%u %.0f %.1f %d %.1f\n", getLE(sample, 4), vario.getPressure(), vario.getSmoothedPressure(),
+           vario.getVerticalSpeed(), vario.getVerticalAcceleration());
+    samples++;
+  }
+  fclose(file);
+  fprintf(stderr, "samples: %u of %u\n", samples, cnt);
+  return samples == cnt ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc >= 3 && strcmp(argv[1], "scenario") == 0) {
+    return runScenario(argc, argv);
+  }
+  if (argc == 3 && strcmp(argv[1], "blackbox") == 0) {
+    return runBlackBox(argv);
+  }
+  fprintf(stderr, "usage: %s scenario <0-3> [climb rate m/s] [turbulence m/s] [sample interval ms]\n"
+                  "       %s blackbox <dump file>\n", argv[0], argv[0]);
+  return 2;
+}
@@ -0,0 +1,56 @@
+/*
+Arduino.h - Minimal Arduino API for host builds of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// only the parts used by the library sources, so that the calculation, filter and
+// scenario code can be run on the host (see the host tools in extras/)
+
+#ifndef HOST_ARDUINO_h
+#define HOST_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+typedef bool boolean;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long aTime);
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+template<class T> T min(T a, T b) { return a < b ? a : b; }
+template<class T> T max(T a, T b) { return a > b ? a : b; }
+
+class Print
+{
+    public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t aByte) = 0;
+	virtual size_t write(const uint8_t* aData, size_t aLength) {
+	  size_t n = 0;
+	  while (aLength-- > 0) {
+	    n += write(*aData++);
+	  }
+	  return n;
+	}
+	virtual int availableForWrite(void) { return 0; }
+};
+
+#endif
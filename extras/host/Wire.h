@@ -0,0 +1,41 @@
+/*
+Wire.h - I2C stub for host builds of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// there is no MS5611 on the host, use VarioMS5611::begin(const uint16_t*)
+
+#ifndef HOST_WIRE_h
+#define HOST_WIRE_h
+
+#include "Arduino.h"
+
+class TwoWire
+{
+    public:
+	void begin(void) {}
+	void beginTransmission(uint8_t) {}
+	uint8_t endTransmission(void) { return 0; }
+	uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+	int available(void) { return 0; }
+	int read(void) { return -1; }
+	size_t write(uint8_t) { return 1; }
+};
+
+extern TwoWire Wire;
+
+#endif
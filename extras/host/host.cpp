@@ -0,0 +1,40 @@
+/*
+host.cpp - Minimal Arduino runtime for host builds of the VarioMS5611 Arduino Library.
+
+(c) 2021 Rainer Stransky
+www.so-fa.de
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the version 3 GNU General Public License as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "Wire.h"
+
+TwoWire Wire;
+
+unsigned long micros(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+unsigned long millis(void) {
+  return micros() / 1000;
+}
+
+void delay(unsigned long aTime) {
+  struct timespec wait = { (time_t) (aTime / 1000), (long) (aTime % 1000) * 1000000L };
+  nanosleep(&wait, NULL);
+}